@@ -57,6 +57,13 @@
  *
  *      Other options:
  *        --unixctl=SOCKET        override default control socket name
+ *        --txn-max-rows=N        rows per OVSDB transaction, 0 for no limit
+ *                                (default: 256)
+ *        --eval-threads=N        threads evaluating interfaces, 0 for auto
+ *        --fwd-damping=LAYER:HOLD_DOWN[:HALF_LIFE]
+ *                                keep LAYER blocked for HOLD_DOWN ms, and damp
+ *                                its flaps with a penalty of HALF_LIFE ms
+ *        --record=FILE           record the OVSDB changes processed into FILE
  *        -h, --help              display this help message
  *
  *
@@ -66,7 +73,20 @@
  *      exit
  *      list-commands
  *      version
- *      ops-intfd/dump              dumps daemons internal data for debugging.
+ *      ops-intfd/dump [--json] [reason=R] [connector=C] [split=S] [admin=A]
+ *                     [interface]
+ *                                  dumps daemons internal data for debugging.
+ *      ops-intfd/startup-stats     time from System:cur_cfg to the first commit.
+ *      ops-intfd/perf [reset]      latency of each phase of the main loop.
+ *      ops-intfd/latency [interface]
+ *                                  config to hardware latency of interfaces.
+ *      ops-intfd/history interface
+ *                                  op state transitions of an interface.
+ *      ops-intfd/top [N] [10s|1m|5m]
+ *                                  interfaces with the most evaluation time.
+ *      ops-intfd/record [FILE|stop]
+ *                                  record the OVSDB changes processed.
+ *      ops-intfd/eventlog          queue and counters of the event log writer.
  *      vlog/disable-rate-limit [module]...
  *      vlog/enable-rate-limit  [module]...
  *      vlog/list
@@ -213,25 +233,26 @@
 #define INTFD_AUTONEG_CAPABILITY_OPTIONAL         11
 #define INTFD_AUTONEG_CAPABILITY_REQUIRED         12
 
+/* Default upper bound on the number of rows written per transaction. */
+#define INTFD_DEFAULT_TXN_MAX_ROWS               256
+
+/* Maximum number of forwarding layers per interface */
+#define INTFD_ARBITER_MAX_LAYERS                   8
+
+/* Maximum number of protocols per forwarding layer */
+#define INTFD_ARBITER_MAX_PROTOS                  32
+
 /* A protocol object part of some forwarding layer object */
 struct intfd_arbiter_proto_class {
     /* The id associated with the protocol */
     enum ovsrec_interface_forwarding_state_proto_e id;
 
-    /* The forwarding layer to which this protocol belongs to */
-    struct intfd_arbiter_layer_class *layer;
-
-    /* Function that runs and determines if the forwarding state
-     * needs to change based on the current protocols state */
-    bool (*run) (struct intfd_arbiter_proto_class *proto,
-                 const struct ovsrec_interface *ifrow);
+    /* The name of the protocol, as set in the owner key of its layer */
+    const char *name;
 
     /* Function that returns the protocols view of the forwarding
      * state of the interface. */
     bool (*get_state) (const struct ovsrec_interface *ifrow);
-
-    /* Next protocol in the forwarding layer */
-    struct intfd_arbiter_proto_class *next;
 };
 
 /* A forwarding layer object */
@@ -239,41 +260,116 @@ struct intfd_arbiter_layer_class {
     /* The id associated with the forwarding layer */
     enum ovsrec_interface_forwarding_state_layer_e id;
 
-    /* The protocol that is currently determining the state of the forwarding layer */
-    enum ovsrec_interface_forwarding_state_proto_e owner;
+    /* The name of the layer, as used on the command line */
+    const char *name;
+
+    /* OVSDB key names for the forwarding state of the layer and for the
+     * protocol dictating it */
+    const char *key;
+    const char *owner_key;
 
-    /* A list of protocols operating at this layer.
-     * The order of the list determines precedence among protocols.
+    /* The protocols operating at this layer.
+     * The order of the array determines precedence among protocols.
      * The protocol at the lower index trumps the one at a higher index. */
-    struct intfd_arbiter_proto_class *protos;
+    const struct intfd_arbiter_proto_class *protos;
+    size_t n_protos;
+};
+
+/* The forwarding state of an interface as computed by the arbiter.
+ * Layers are indexed by their position in the hierarchy. */
+struct intfd_arbiter_result {
+    /* Bitmask of the forwarding layers that are blocked */
+    uint8_t blocked;
 
-    /* Boolean variable that tells if the forwarding state of the give layer is blocked */
-    bool blocked;
+    /* Bitmask of the blocked forwarding layers that have an owner */
+    uint8_t owned;
 
-    /* Function that determines if the forwarding state of the layer has to change */
-    bool (*run) (struct intfd_arbiter_layer_class *layer,
-                 const struct ovsrec_interface *ifrow);
+    /* For each owned layer, the position of the owner in the layer */
+    uint8_t owner[INTFD_ARBITER_MAX_LAYERS];
+};
 
-    /* Pointer to the previous forwarding layer in the hierarchy */
-    struct intfd_arbiter_layer_class *prev;
+/* The hysteresis of a forwarding layer */
+struct intfd_arbiter_damping {
+    /* Minimum time a layer blocked by a protocol stays blocked, in ms */
+    long long int hold_down;
 
-    /* Pointer to the next forwarding layer in the hierarchy */
-    struct intfd_arbiter_layer_class *next;
+    /* Half life of the flap penalty in ms, 0 if flap damping is disabled */
+    long long int half_life;
 };
 
-/* An interface arbiter object */
-struct intfd_arbiter_class {
-    /* A list of forwarding layers applicable for this object */
-    struct intfd_arbiter_layer_class *layers;
+/* The hysteresis state of a forwarding layer of an interface */
+struct intfd_arbiter_hold {
+    /* Time at which a protocol last blocked the layer */
+    long long int blocked_since;
+
+    /* Flap penalty, and the time at which it was last decayed */
+    uint32_t penalty;
+    long long int penalty_msec;
+
+    /* True while the penalty is above the reuse threshold */
+    bool suppressed;
+
+    /* True if the layer is kept blocked by the hysteresis */
+    bool held;
+
+    /* Number of times the hysteresis kept the layer blocked */
+    uint32_t n_suppressed;
+};
+
+/* Arbiter state kept by the caller for each interface */
+struct intfd_arbiter_state {
+    /* False until the interface has been evaluated once */
+    bool evaluated;
+
+    /* True if the forwarding state column may not hold the result of the
+     * last evaluation, e.g. because its transaction failed */
+    bool row_stale;
+
+    /* The operator state of the interface at the last evaluation */
+    bool oper_up;
+
+    /* The result of the last evaluation */
+    struct intfd_arbiter_result result;
+
+    /* For each forwarding layer, the bitmask of the protocols asserting
+     * block, indexed by the position of the protocol in the layer */
+    uint32_t asserting[INTFD_ARBITER_MAX_LAYERS];
+
+    /* The hysteresis state of each forwarding layer */
+    struct intfd_arbiter_hold holds[INTFD_ARBITER_MAX_LAYERS];
+
+    /* Earliest time at which a held layer may forward, 0 if none is held */
+    long long int hold_until;
 };
 
 extern void intfd_ovsdb_init(const char *db_path);
 extern void intfd_ovsdb_exit(void);
 extern void intfd_run(void);
 extern void intfd_wait(void);
-extern void intfd_debug_dump(struct ds *ds, int argc, const char *argv[]);
+struct intfd_dump;
+extern struct intfd_dump *intfd_dump_create(int argc, const char *argv[],
+                                            char **errorp);
+extern void intfd_dump_run(const struct intfd_dump *dump, struct ds *ds);
+extern void intfd_dump_destroy(struct intfd_dump *dump);
+struct intfd_snapshot;
+extern struct intfd_snapshot *intfd_snapshot_get(void);
+extern void intfd_snapshot_unref(struct intfd_snapshot *snap);
+extern void intfd_startup_stats_dump(struct ds *ds);
+extern void intfd_latency_dump(struct ds *ds, const char *interface_name);
+extern void intfd_history_dump(struct ds *ds, const char *interface_name);
+extern bool intfd_top_dump(struct ds *ds, size_t n, const char *window);
+extern void intfd_set_txn_max_rows(unsigned int max_rows);
 extern void intfd_arbiter_init(void);
-extern void intfd_arbiter_interface_run(const struct ovsrec_interface *ifrow,
-        struct smap *forwarding_state);
+extern bool intfd_arbiter_interface_run(const struct ovsrec_interface *ifrow,
+        struct intfd_arbiter_state *state, long long int now);
+extern bool intfd_arbiter_update_inputs(const struct ovsrec_interface *ifrow,
+        struct intfd_arbiter_state *state, long long int now);
+extern bool intfd_arbiter_set_damping(const char *layer_name,
+        long long int hold_down, long long int half_life);
+extern void intfd_arbiter_dump_holds(struct ds *ds,
+        const struct intfd_arbiter_state *state, long long int now);
+struct json;
+extern struct json *intfd_arbiter_dump_holds_json(
+        const struct intfd_arbiter_state *state, long long int now);
 #endif /* __INTFD_H__ */
 /** @} end of group ops-intfd */
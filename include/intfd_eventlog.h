@@ -0,0 +1,46 @@
+/*
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+/************************************************************************//**
+ * @ingroup ops-intfd
+ *
+ * @file
+ * Header for the asynchronous event log writer of ops-intfd.
+ *
+ ***************************************************************************/
+
+#ifndef __INTFD_EVENTLOG_H__
+#define __INTFD_EVENTLOG_H__
+
+/** @ingroup ops-intfd
+ * @{ */
+
+struct ds;
+
+/* Events of the "INTERFACE" event log category. */
+enum intfd_event {
+    INTFD_EVENT_INTERFACE_UP,
+    INTFD_EVENT_INTERFACE_DOWN,
+    INTFD_N_EVENTS
+};
+
+extern void intfd_eventlog_init(void);
+extern void intfd_eventlog_exit(void);
+extern void intfd_eventlog_post(enum intfd_event event, const char *intf_name);
+extern void intfd_eventlog_dump(struct ds *ds);
+
+/** @} end of group ops-intfd */
+
+#endif /* __INTFD_EVENTLOG_H__ */
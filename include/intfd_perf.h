@@ -0,0 +1,94 @@
+/*
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+/************************************************************************//**
+ * @ingroup ops-intfd
+ *
+ * @file
+ * Header for the ops-intfd main loop latency instrumentation.
+ *
+ ***************************************************************************/
+
+#ifndef __INTFD_PERF_H__
+#define __INTFD_PERF_H__
+
+#include <time.h>
+
+/** @ingroup ops-intfd
+ * @{ */
+
+/* The phases of an intfd_run() iteration. */
+enum intfd_perf_phase {
+    INTFD_PERF_IDL_RUN,             /* ovsdb_idl_run() */
+    INTFD_PERF_PORT_RECONFIGURE,    /* port_reconfigure() */
+    INTFD_PERF_CONFIG_MODS,         /* handle_interfaces_config_mods() */
+    INTFD_PERF_EVALUATE,            /* intfd_evaluate_pending() */
+    INTFD_PERF_FLUSH,               /* intfd_flush_writes(), chunk commits
+                                     * included */
+    INTFD_PERF_ARBITER,             /* intfd_arbiter_run(), chunk commits
+                                     * included */
+    INTFD_PERF_SNAPSHOT,            /* intfd_snapshot_publish() */
+    INTFD_PERF_COMMIT,              /* Each ovsdb_idl_txn_commit_block() */
+    INTFD_PERF_ITERATION,           /* A whole iteration that had work */
+    INTFD_PERF_N_PHASES
+};
+
+/* Event counters reported with the phases. */
+enum intfd_perf_counter {
+    INTFD_PERF_ROWS_CHANGED,        /* Interface rows inserted or modified */
+    INTFD_PERF_ROWS_WRITTEN,        /* Interface rows written */
+    INTFD_PERF_COMMITS,             /* Transactions committed */
+    INTFD_PERF_N_COUNTERS
+};
+
+/* A log-linear latency histogram, in ns. */
+#define INTFD_PERF_SUB_BITS     3
+#define INTFD_PERF_SUB_BUCKETS  (1 << INTFD_PERF_SUB_BITS)
+#define INTFD_PERF_N_BUCKETS    ((64 - INTFD_PERF_SUB_BITS + 1) \
+                                 * INTFD_PERF_SUB_BUCKETS)
+
+struct intfd_perf_histogram {
+    unsigned long long int count;
+    unsigned long long int total;
+    unsigned long long int max;
+    unsigned long long int buckets[INTFD_PERF_N_BUCKETS];
+};
+
+/* Returns a monotonic timestamp, in ns, to pass to intfd_perf_end(). */
+static inline long long int
+intfd_perf_start(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+extern void intfd_perf_histogram_record(struct intfd_perf_histogram *h,
+                                        unsigned long long int value);
+extern unsigned long long int intfd_perf_histogram_percentile(
+        const struct intfd_perf_histogram *h, unsigned int pct);
+extern void intfd_perf_end(enum intfd_perf_phase phase, long long int start);
+extern void intfd_perf_count(enum intfd_perf_counter counter,
+                             unsigned long long int n);
+extern void intfd_perf_publish(void);
+extern void intfd_perf_reset(void);
+
+struct ds;
+extern void intfd_perf_dump(struct ds *ds);
+
+/** @} end of group ops-intfd */
+
+#endif /* __INTFD_PERF_H__ */
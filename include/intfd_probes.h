@@ -0,0 +1,59 @@
+/*
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+/************************************************************************//**
+ * @ingroup ops-intfd
+ *
+ * @file
+ * Static tracepoints (USDT) of ops-intfd.
+ *
+ * The probes are in the "ops_intfd" provider.  Each one compiles to a
+ * single nop, which a tracer such as the bpftrace scripts in
+ * utilities/usdt-scripts replaces with a breakpoint when it attaches.
+ * The arguments must be cheap to compute: they are evaluated whether a
+ * tracer is attached or not.  Without <sys/sdt.h> the probes compile to
+ * nothing.
+ *
+ *   row_changed(name, inserted)          Interface row change observed.
+ *   intf_evaluated(name, enabled, reason) Interface evaluated.
+ *   write_emitted(name)                  hw_intf_config of a row written.
+ *   commit_start(rows)                   Transaction commit started.
+ *   commit_finish(status)                Transaction commit finished.
+ *   arbiter_decision(name, blocked, owned) forwarding_state updated.
+ *
+ ***************************************************************************/
+
+#ifndef __INTFD_PROBES_H__
+#define __INTFD_PROBES_H__
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+
+#define INTFD_PROBE(NAME) \
+    DTRACE_PROBE(ops_intfd, NAME)
+#define INTFD_PROBE1(NAME, ARG1) \
+    DTRACE_PROBE1(ops_intfd, NAME, ARG1)
+#define INTFD_PROBE2(NAME, ARG1, ARG2) \
+    DTRACE_PROBE2(ops_intfd, NAME, ARG1, ARG2)
+#define INTFD_PROBE3(NAME, ARG1, ARG2, ARG3) \
+    DTRACE_PROBE3(ops_intfd, NAME, ARG1, ARG2, ARG3)
+#else
+#define INTFD_PROBE(NAME)
+#define INTFD_PROBE1(NAME, ARG1)
+#define INTFD_PROBE2(NAME, ARG1, ARG2)
+#define INTFD_PROBE3(NAME, ARG1, ARG2, ARG3)
+#endif
+
+#endif /* __INTFD_PROBES_H__ */
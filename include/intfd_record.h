@@ -0,0 +1,41 @@
+/*
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+/************************************************************************//**
+ * @ingroup ops-intfd
+ *
+ * @file
+ * Header for the recorder of the OVSDB changes processed by ops-intfd.
+ *
+ ***************************************************************************/
+
+#ifndef __INTFD_RECORD_H__
+#define __INTFD_RECORD_H__
+
+#include <stdbool.h>
+
+/** @ingroup ops-intfd
+ * @{ */
+
+struct ovsdb_idl;
+
+extern bool intfd_record_start(const char *file_name, char **errorp);
+extern void intfd_record_stop(void);
+extern const char *intfd_record_file_name(void);
+extern void intfd_record_run(const struct ovsdb_idl *idl);
+
+/** @} end of group ops-intfd */
+
+#endif /* __INTFD_RECORD_H__ */
@@ -0,0 +1,50 @@
+/*
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+/************************************************************************//**
+ * @ingroup ops-intfd
+ *
+ * @file
+ * Header for the ovs-appctl service thread of ops-intfd.
+ *
+ ***************************************************************************/
+
+#ifndef __INTFD_UNIXCTL_H__
+#define __INTFD_UNIXCTL_H__
+
+#include <stdbool.h>
+
+/** @ingroup ops-intfd
+ * @{ */
+
+struct ds;
+struct unixctl_server;
+
+/* A command run by the main thread.  Appends the reply to 'reply' and
+ * returns true, or appends an error message and returns false. */
+typedef bool intfd_unixctl_main_cb(int argc, const char *argv[], void *aux,
+                                   struct ds *reply);
+
+extern void intfd_unixctl_register_main(const char *name, const char *usage,
+                                        int min_args, int max_args,
+                                        intfd_unixctl_main_cb *cb, void *aux);
+extern void intfd_unixctl_start(struct unixctl_server *server);
+extern void intfd_unixctl_stop(void);
+extern void intfd_unixctl_run(void);
+extern void intfd_unixctl_wait(void);
+
+/** @} end of group ops-intfd */
+
+#endif /* __INTFD_UNIXCTL_H__ */
@@ -0,0 +1,46 @@
+/*
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+/************************************************************************//**
+ * @ingroup ops-intfd
+ *
+ * @file
+ * Header for the ops-intfd evaluation worker pool.
+ *
+ ***************************************************************************/
+
+#ifndef __INTFD_WORKERS_H__
+#define __INTFD_WORKERS_H__
+
+#include <stddef.h>
+
+/** @ingroup ops-intfd
+ * @{ */
+
+/* Upper bound on the number of evaluation threads picked automatically. */
+#define INTFD_MAX_AUTO_EVAL_THREADS        8
+
+/* Work sets smaller than this are evaluated on the main thread only. */
+#define INTFD_PARALLEL_EVAL_MIN          512
+
+extern void intfd_workers_init(unsigned int n_threads);
+extern void intfd_workers_exit(void);
+extern unsigned int intfd_workers_count(void);
+extern void intfd_workers_run(void (*fn)(void *item), void **items,
+                              size_t n_items);
+
+/** @} end of group ops-intfd */
+
+#endif /* __INTFD_WORKERS_H__ */
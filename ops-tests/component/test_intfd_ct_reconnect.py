@@ -0,0 +1,130 @@
+# (C) Copyright 2016 Hewlett Packard Enterprise Development LP
+# All Rights Reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+#
+##########################################################################
+
+"""
+OpenSwitch Test for the resync of ops-intfd after an ovsdb-server restart.
+
+ovsdb-server is stopped, the database file is changed offline, so the
+changes happen while ops-intfd is disconnected, and ovsdb-server is started
+again with the same command line.  ops-intfd must apply the changes once
+the rows are re-sent, and keep running.
+"""
+
+from time import sleep
+
+TOPOLOGY = """
+# +-------+
+# |  ops1 |
+# +-------+
+
+# Nodes
+[type=openswitch name="OpenSwitch 1"] ops1
+
+# Links
+ops1:if01
+ops1:if02
+ops1:if03
+ops1:if04
+"""
+
+
+RESYNC_TIMEOUT_S = 30
+
+
+def get_enable(dut, intf):
+    out = dut("ovs-vsctl get interface {intf} hw_intf_config:enable".format(
+        intf=intf), shell="bash")
+    return out.strip().strip('"')
+
+
+def wait_enable(dut, intf, expected):
+    for _ in range(RESYNC_TIMEOUT_S * 2):
+        if get_enable(dut, intf) == expected:
+            return True
+        sleep(0.5)
+    return False
+
+
+def transact(ops):
+    return ("ovsdb-tool transact $db '[\"OpenSwitch\"" + "".join(
+        "," + op for op in ops) + "]'; ")
+
+
+def set_row(table, name, column, value):
+    return ("{\"op\":\"update\",\"table\":\"" + table + "\","
+            "\"where\":[[\"name\",\"==\",\"" + name + "\"]],"
+            "\"row\":{\"" + column + "\":" + value + "}}")
+
+
+def test_intfd_ct_reconnect(topology, step):
+    ops1 = topology.get("ops1")
+    assert ops1 is not None
+
+    if01 = ops1.ports["if01"]
+    if02 = ops1.ports["if02"]
+    if03 = ops1.ports["if03"]
+    if04 = ops1.ports["if04"]
+
+    step("Step 1- Configure if01 admin down, if02 admin up, and if03 and "
+         "if04 in an admin up LAG")
+    with ops1.libs.vtysh.ConfigInterface("if01") as ctx:
+        ctx.shutdown()
+    with ops1.libs.vtysh.ConfigInterface("if02") as ctx:
+        ctx.no_shutdown()
+    with ops1.libs.vtysh.ConfigInterfaceLag("100") as ctx:
+        ctx.no_shutdown()
+    for port in ("if03", "if04"):
+        with ops1.libs.vtysh.ConfigInterface(port) as ctx:
+            ctx.no_shutdown()
+            ctx.lag("100")
+    assert wait_enable(ops1, if01, "false")
+    assert wait_enable(ops1, if02, "true")
+    assert wait_enable(ops1, if03, "true")
+    assert wait_enable(ops1, if04, "true")
+    pid = ops1("pidof ops-intfd", shell="bash").strip()
+
+    step("Step 2- Stop ovsdb-server and, while ops-intfd is disconnected, "
+         "set if01 admin up, if02 admin down and the LAG admin down")
+    ops1("pid=$(pidof ovsdb-server); "
+         "tr '\\0' ' ' < /proc/$pid/cmdline > /tmp/ovsdb-server.cmdline; "
+         "db=$(tr '\\0' '\\n' < /proc/$pid/cmdline | grep '\\.db$'); "
+         "echo $db > /tmp/ovsdb-server.db; "
+         "kill $pid; "
+         "while kill -0 $pid 2> /dev/null; do sleep 0.1; done",
+         shell="bash")
+    ops1("db=$(cat /tmp/ovsdb-server.db); " + transact([
+        set_row("Interface", if01, "user_config",
+                "[\"map\",[[\"admin\",\"up\"]]]"),
+        set_row("Interface", if02, "user_config",
+                "[\"map\",[[\"admin\",\"down\"]]]"),
+        set_row("Port", "lag100", "admin", "\"down\"")]), shell="bash")
+
+    step("Step 3- Start ovsdb-server again")
+    ops1("$(cat /tmp/ovsdb-server.cmdline) --detach", shell="bash")
+
+    step("Step 4- Verify ops-intfd applied the changes made while it was "
+         "disconnected")
+    assert wait_enable(ops1, if01, "true")
+    assert wait_enable(ops1, if02, "false")
+    assert wait_enable(ops1, if03, "false")
+    assert wait_enable(ops1, if04, "false")
+
+    step("Step 5- Verify ops-intfd kept running and still follows changes")
+    assert ops1("pidof ops-intfd", shell="bash").strip() == pid
+    ops1("ovs-vsctl set port lag100 admin=up", shell="bash")
+    assert wait_enable(ops1, if03, "true")
+    assert wait_enable(ops1, if04, "true")
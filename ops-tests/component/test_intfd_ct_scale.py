@@ -0,0 +1,255 @@
+# (C) Copyright 2016 Hewlett Packard Enterprise Development LP
+# All Rights Reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+#
+##########################################################################
+
+"""
+OpenSwitch Test for the convergence time of ops-intfd at scale.
+
+Hundreds of synthetic interfaces are created in the ovsdb-server of the
+switch: SFP+ ports and QSFP+ ports with 4 split children each, every one in
+a port of its own.  Bulk operations are then applied in a single ovs-vsctl
+transaction each, and the time until the number of enabled interfaces, or
+of disabled ones for the creation, reaches its expected value, as well as the number of transactions ops-intfd
+committed for it, are checked against budgets.
+"""
+
+from time import sleep
+
+TOPOLOGY = """
+# +-------+
+# |  ops1 |
+# +-------+
+
+# Nodes
+[type=openswitch name="OpenSwitch 1"] ops1
+"""
+
+
+N_SFP = 192
+N_QSFP = 16
+N_LAGS = 16
+LAG_SIZE = 8
+USER_MTU = 1500
+LOW_SUBSYSTEM_MTU = 1000
+
+# Budgets of a bulk operation.  ops-intfd writes at most 256 rows per
+# transaction (--txn-max-rows), an interface row counting once for its
+# H/W config and forwarding state alike.  Two transactions are left for
+# the writes that follow on a later run of the main loop.
+CONVERGENCE_BUDGET_MS = 5000
+TXN_ROWS = 256
+
+# The sizes, as shell variables for the scripts below.
+SCALE_VARS = ("n_sfp=" + str(N_SFP) + "; n_qsfp=" + str(N_QSFP) +
+              "; n_lags=" + str(N_LAGS) + "; lag_size=" + str(LAG_SIZE) +
+              "; user_mtu=" + str(USER_MTU) + "; ")
+
+SFP_ROW = ("type=system hw_intf_info:connector=SFP_PLUS "
+           "hw_intf_info:pluggable=true hw_intf_info:speeds=10000 "
+           "hw_intf_info:max_speed=10000 pm_info:connector=SFP_SR "
+           "pm_info:connector_status=supported")
+QSFP_ROW = ("type=system hw_intf_info:connector=QSFP_PLUS "
+            "hw_intf_info:pluggable=true hw_intf_info:speeds=40000 "
+            "hw_intf_info:max_speed=40000 pm_info:connector=QSFP_CR4 "
+            "pm_info:connector_status=supported")
+CHILD_ROW = ("type=system hw_intf_info:connector=QSFP_PLUS "
+             "hw_intf_info:pluggable=true hw_intf_info:speeds=10000 "
+             "hw_intf_info:max_speed=10000")
+
+# Every synthetic row, admin down, each in a port of its own.  The split
+# children refer to their parent before ovs-vsctl creates it.
+CREATE = SCALE_VARS + (
+    "args=''; "
+    "for i in $(seq 1 $n_sfp); do "
+    "args=\"$args -- --id=@i$i create interface name=sc-s$i " + SFP_ROW +
+    " user_config:admin=down user_config:mtu=$user_mtu"
+    " -- --id=@p$i create port name=sc-s$i admin=up interfaces=@i$i"
+    " -- add vrf vrf_default ports @p$i\"; "
+    "done; "
+    "for i in $(seq 1 $n_qsfp); do "
+    "c=''; "
+    "for j in 1 2 3 4; do "
+    "args=\"$args -- --id=@c$i.$j create interface name=sc-q$i-$j " +
+    CHILD_ROW + " user_config:admin=down split_parent=@q$i"
+    " -- --id=@cp$i.$j create port name=sc-q$i-$j admin=up"
+    " interfaces=@c$i.$j -- add vrf vrf_default ports @cp$i.$j\"; "
+    "c=\"$c,@c$i.$j\"; "
+    "done; "
+    "args=\"$args -- --id=@q$i create interface name=sc-q$i " + QSFP_ROW +
+    " user_config:admin=down split_children=[${c#,}]"
+    " -- --id=@qp$i create port name=sc-q$i admin=up interfaces=@q$i"
+    " -- add vrf vrf_default ports @qp$i\"; "
+    "done; ")
+
+ALL_UP = (
+    "args=$(ovs-vsctl --bare --columns=name list interface"
+    " | grep '^sc-' | sed 's/.*/-- set interface & user_config:admin=up/'); ")
+
+ALL_SPLIT = SCALE_VARS + (
+    "args=$(for i in $(seq 1 $n_qsfp); do"
+    " echo \"-- set interface sc-q$i user_config:lane_split=split\"; "
+    "done); ")
+
+# The first LAG_SIZE * N_LAGS SFP+ interfaces move into LAGs that are
+# admin down.
+LAG_CREATE = SCALE_VARS + (
+    "args=''; "
+    "for k in $(seq 1 $n_lags); do "
+    "m=''; "
+    "for j in $(seq 1 $lag_size); do "
+    "i=$(( (k - 1) * lag_size + j )); "
+    "m=\"$m,$(ovs-vsctl get interface sc-s$i _uuid)\"; "
+    "args=\"$args -- clear port sc-s$i interfaces\"; "
+    "done; "
+    "args=\"$args -- --id=@l$k create port name=sc-lag$k admin=down"
+    " interfaces=[${m#,}] -- add vrf vrf_default ports @l$k\"; "
+    "done; ")
+
+LAG_DELETE = SCALE_VARS + (
+    "args=''; "
+    "for k in $(seq 1 $n_lags); do "
+    "args=\"$args -- remove vrf vrf_default ports"
+    " $(ovs-vsctl get port sc-lag$k _uuid) -- destroy port sc-lag$k\"; "
+    "for j in $(seq 1 $lag_size); do "
+    "i=$(( (k - 1) * lag_size + j )); "
+    "args=\"$args -- add port sc-s$i interfaces"
+    " $(ovs-vsctl get interface sc-s$i _uuid)\"; "
+    "done; "
+    "done; ")
+
+DESTROY = (
+    "args=$(ovs-vsctl --bare --columns=_uuid,name list port"
+    " | awk 'NF { a[++n] = $0 } END { for (i = 1; i < n; i += 2)"
+    " if (a[i + 1] ~ /^sc-/) print \"-- remove vrf vrf_default ports \" a[i]"
+    " \" -- destroy port \" a[i] }'); "
+    "args=\"$args $(ovs-vsctl --bare --columns=name list interface"
+    " | grep '^sc-' | sed 's/.*/-- --if-exists destroy interface &/')\"; ")
+
+COUNT_ENABLED = ("ovs-vsctl --bare --columns=name find interface"
+                 " hw_intf_config:enable=true | grep -c '^sc-'")
+COUNT_DISABLED = ("ovs-vsctl --bare --columns=name find interface"
+                  " hw_intf_config:enable=false | grep -c '^sc-'")
+
+
+def get_commits(dut):
+    out = dut("ovs-appctl -t ops-intfd ops-intfd/perf", shell="bash")
+    for line in out.splitlines():
+        if line.startswith("Commits"):
+            return int(line.split()[1])
+    assert False, "no commit counter in ops-intfd/perf"
+
+
+def timed_bulk_op(dut, prepare, expected, count=COUNT_ENABLED):
+    """Runs the ovs-vsctl arguments built by 'prepare' as one transaction,
+    and returns the ms until 'count' finds 'expected' synthetic interfaces,
+    by default the enabled ones, and the number of transactions ops-intfd
+    committed."""
+
+    commits = get_commits(dut)
+    out = dut(prepare +
+              "start=$(date +%s%N); "
+              "ovs-vsctl $args; "
+              "while [ \"$(" + count + ")\" != \"" +
+              str(expected) + "\" ]; do "
+              "[ $(( ($(date +%s%N) - start) / 1000000 )) -gt " +
+              str(2 * CONVERGENCE_BUDGET_MS) + " ] && break; "
+              "sleep 0.01; "
+              "done; "
+              "echo elapsed=$(( ($(date +%s%N) - start) / 1000000 )) "
+              "found=$(" + count + ")", shell="bash")
+
+    result = dict(field.split("=") for field in out.split()
+                  if "=" in field)
+    assert int(result["found"]) == expected
+
+    # Let the arbiter commit after the last hardware configuration write.
+    sleep(1)
+    return int(result["elapsed"]), get_commits(dut) - commits
+
+
+def check_budgets(step, name, elapsed, commits, rows):
+    txn_budget = (rows + TXN_ROWS - 1) // TXN_ROWS + 2
+    step("{name}: converged in {elapsed} ms with {commits} transactions "
+         "(budget {budget_ms} ms, {txn_budget} transactions)".format(
+             name=name, elapsed=elapsed, commits=commits,
+             budget_ms=CONVERGENCE_BUDGET_MS, txn_budget=txn_budget))
+    assert elapsed <= CONVERGENCE_BUDGET_MS
+    assert commits <= txn_budget
+
+
+def test_intfd_ct_scale(topology, step):
+    ops1 = topology.get("ops1")
+    assert ops1 is not None
+
+    n_intfs = N_SFP + 5 * N_QSFP
+    n_lag_members = N_LAGS * LAG_SIZE
+
+    mtu = ops1("ovs-vsctl get subsystem base "
+               "other_info:max_transmission_unit",
+               shell="bash").strip().strip('"')
+    assert int(mtu) >= USER_MTU
+
+    step("Step 1- Create {n} interfaces, admin down: ops-intfd writes "
+         "them all disabled".format(n=n_intfs))
+    elapsed, commits = timed_bulk_op(ops1, CREATE, n_intfs, COUNT_DISABLED)
+    check_budgets(step, "create", elapsed, commits, n_intfs)
+
+    try:
+        step("Step 2- Set all the interfaces admin up: the SFP+ and the "
+             "QSFP+ ports are enabled, the split children are not")
+        elapsed, commits = timed_bulk_op(ops1, ALL_UP, N_SFP + N_QSFP)
+        check_budgets(step, "all-up", elapsed, commits, N_SFP + N_QSFP)
+
+        step("Step 3- Split all the QSFP+ ports")
+        elapsed, commits = timed_bulk_op(ops1, ALL_SPLIT,
+                                         N_SFP + 4 * N_QSFP)
+        check_budgets(step, "all-split", elapsed, commits, 5 * N_QSFP)
+
+        step("Step 4- Move {n} interfaces into {lags} LAGs admin "
+             "down".format(n=n_lag_members, lags=N_LAGS))
+        elapsed, commits = timed_bulk_op(
+            ops1, LAG_CREATE, N_SFP - n_lag_members + 4 * N_QSFP)
+        check_budgets(step, "lag-create", elapsed, commits, n_lag_members)
+
+        step("Step 5- Delete the LAGs, the interfaces return to their own "
+             "ports")
+        elapsed, commits = timed_bulk_op(ops1, LAG_DELETE,
+                                         N_SFP + 4 * N_QSFP)
+        check_budgets(step, "lag-delete", elapsed, commits, n_lag_members)
+
+        step("Step 6- Lower the subsystem MTU below the user MTU of the SFP+ "
+             "interfaces")
+        elapsed, commits = timed_bulk_op(
+            ops1, "args='set subsystem base other_info:"
+            "max_transmission_unit=" + str(LOW_SUBSYSTEM_MTU) + "'; ",
+            4 * N_QSFP)
+        check_budgets(step, "mtu-lower", elapsed, commits, N_SFP)
+
+        step("Step 7- Restore the subsystem MTU")
+        elapsed, commits = timed_bulk_op(
+            ops1, "args='set subsystem base other_info:"
+            "max_transmission_unit=" + mtu + "'; ",
+            N_SFP + 4 * N_QSFP)
+        check_budgets(step, "mtu-restore", elapsed, commits, N_SFP)
+
+    finally:
+        step("Step 8- Cleanup")
+        ops1("ovs-vsctl set subsystem base other_info:"
+             "max_transmission_unit=" + mtu, shell="bash")
+        ops1(DESTROY + "ovs-vsctl $args", shell="bash")
+        out = ops1("ovs-vsctl --bare --columns=name list interface "
+                   "| grep -c '^sc-'", shell="bash")
+        assert out.strip() == "0"
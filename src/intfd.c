@@ -36,6 +36,7 @@
  ***************************************************************************/
 
 #include <stdio.h>
+#include <ctype.h>
 #include <errno.h>
 #include <getopt.h>
 #include <limits.h>
@@ -51,6 +52,7 @@
 #include <dynamic-string.h>
 #include <fatal-signal.h>
 #include <ovsdb-idl.h>
+#include <ovs-thread.h>
 #include <poll-loop.h>
 #include <unixctl.h>
 #include <util.h>
@@ -62,12 +64,20 @@
 #include <shash.h>
 
 #include "intfd.h"
-#include "eventlog.h"
+#include "intfd_eventlog.h"
+#include "intfd_perf.h"
+#include "intfd_record.h"
+#include "intfd_unixctl.h"
+#include "intfd_workers.h"
 #include <diag_dump.h>
 
 VLOG_DEFINE_THIS_MODULE(ops_intfd);
 
-#define DIAGNOSTIC_BUFFER_LEN 16000    /*One interface= 700 characters*/
+/* Number of threads evaluating interfaces, 0 to pick from the CPU count. */
+static unsigned int eval_threads = 0;
+
+/* File to record the OVSDB changes into from startup, if any. */
+static char *record_file_name;
 
 /** @ingroup ops-intfd
  * @{ */
@@ -84,22 +94,175 @@ usage(void)
     vlog_usage();
     printf("\nOther options:\n"
            "  --unixctl=SOCKET        override default control socket name\n"
-           "  -h, --help              display this help message\n");
+           "  --txn-max-rows=N        rows per OVSDB transaction, 0 for no limit\n"
+           "                          (default: %d)\n"
+           "  --eval-threads=N        threads evaluating interfaces, 0 for auto\n"
+           "  --fwd-damping=LAYER:HOLD_DOWN[:HALF_LIFE]\n"
+           "                          keep LAYER blocked for HOLD_DOWN ms, and damp\n"
+           "                          its flaps with a penalty of HALF_LIFE ms\n"
+           "  --record=FILE           record the OVSDB changes processed into FILE\n"
+           "  -h, --help              display this help message\n",
+           INTFD_DEFAULT_TXN_MAX_ROWS);
     exit(EXIT_SUCCESS);
 } /* usage */
 
+/* Runs on the service thread, from the published state snapshot. */
 static void
 intfd_unixctl_dump(struct unixctl_conn *conn, int argc,
                           const char *argv[], void *aux OVS_UNUSED)
 {
     struct ds ds = DS_EMPTY_INITIALIZER;
+    struct intfd_dump *dump;
+    char *error = NULL;
+
+    dump = intfd_dump_create(argc - 1, argv + 1, &error);
+    if (!dump) {
+        unixctl_command_reply_error(conn, error);
+        free(error);
+        return;
+    }
 
-    intfd_debug_dump(&ds, argc, argv);
+    intfd_dump_run(dump, &ds);
+    intfd_dump_destroy(dump);
 
     unixctl_command_reply(conn, ds_cstr(&ds));
     ds_destroy(&ds);
 } /* intfd_unixctl_dump */
 
+/* Runs on the service thread, from the published state snapshot. */
+static void
+intfd_unixctl_startup_stats(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                            const char *argv[] OVS_UNUSED,
+                            void *aux OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    intfd_startup_stats_dump(&ds);
+
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+} /* intfd_unixctl_startup_stats */
+
+/* Runs on the service thread, from the statistics the main loop last
+ * published.  A reset is applied by the main loop before it publishes
+ * again. */
+static void
+intfd_unixctl_perf(struct unixctl_conn *conn, int argc, const char *argv[],
+                   void *aux OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    if (argc > 1) {
+        if (strcmp(argv[1], "reset")) {
+            unixctl_command_reply_error(conn, "usage: ops-intfd/perf [reset]");
+            return;
+        }
+        intfd_perf_reset();
+        unixctl_command_reply(conn, "Statistics cleared");
+        return;
+    }
+
+    intfd_perf_dump(&ds);
+
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+} /* intfd_unixctl_perf */
+
+/* Runs on the service thread, from the published state snapshot. */
+static void
+intfd_unixctl_latency(struct unixctl_conn *conn, int argc, const char *argv[],
+                      void *aux OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    intfd_latency_dump(&ds, argc > 1 ? argv[1] : NULL);
+
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+} /* intfd_unixctl_latency */
+
+/* Runs on the service thread, from the published state snapshot. */
+static void
+intfd_unixctl_history(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                      const char *argv[], void *aux OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    intfd_history_dump(&ds, argv[1]);
+
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+} /* intfd_unixctl_history */
+
+static bool
+intfd_unixctl_record(int argc, const char *argv[], void *aux OVS_UNUSED,
+                     struct ds *reply)
+{
+    const char *file_name = intfd_record_file_name();
+    char *error = NULL;
+
+    if (argc < 2) {
+        ds_put_cstr(reply, file_name ? file_name : "not recording");
+        return true;
+    }
+
+    if (!strcmp(argv[1], "stop")) {
+        intfd_record_stop();
+        return true;
+    }
+
+    if (!intfd_record_start(argv[1], &error)) {
+        ds_put_cstr(reply, error);
+        free(error);
+        return false;
+    }
+    ds_put_format(reply, "recording into %s", argv[1]);
+    return true;
+} /* intfd_unixctl_record */
+
+/* Runs on the service thread, from the published state snapshot. */
+static void
+intfd_unixctl_top(struct unixctl_conn *conn, int argc, const char *argv[],
+                  void *aux OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+    const char *window = "10s";
+    unsigned int n = 10;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (isdigit((unsigned char) argv[i][0])) {
+            if (!str_to_uint(argv[i], 10, &n) || !n) {
+                unixctl_command_reply_error(
+                    conn, "usage: ops-intfd/top [N] [10s|1m|5m]");
+                return;
+            }
+        } else {
+            window = argv[i];
+        }
+    }
+
+    if (intfd_top_dump(&ds, n, window)) {
+        unixctl_command_reply(conn, ds_cstr(&ds));
+    } else {
+        unixctl_command_reply_error(conn, ds_cstr(&ds));
+    }
+    ds_destroy(&ds);
+} /* intfd_unixctl_top */
+
+/* Runs on the service thread, the counters are atomic. */
+static void
+intfd_unixctl_eventlog(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                       const char *argv[] OVS_UNUSED, void *aux OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    intfd_eventlog_dump(&ds);
+
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+} /* intfd_unixctl_eventlog */
+
 /*
  * Function         : intfd_diag_dump_basic_cb
  * Responsibility   : callback handler function for diagnostic dump basic
@@ -112,68 +275,134 @@ intfd_unixctl_dump(struct unixctl_conn *conn, int argc,
 static void
 intfd_diag_dump_basic_cb(const char *feature , char **buf)
 {
-    struct ds ds1 = DS_EMPTY_INITIALIZER;
-    const char *argv[]= { "1", "1", NULL};
+    struct ds ds = DS_EMPTY_INITIALIZER;
+    struct intfd_dump *dump;
+
     if (!buf)
         return;
-    *buf = xcalloc(1, DIAGNOSTIC_BUFFER_LEN);
-    if(*buf) {
-        /* populate basic diagnostic data to buffer  */
-        intfd_debug_dump(&ds1, 3, argv);
-        sprintf(*buf, "%s", ds_cstr(&ds1));
-        VLOG_INFO("basic diag-dump data populated for feature %s", feature);
-    } else{
-        VLOG_ERR("Memory allocation failed for feature %s , %d bytes",
-                feature, DIAGNOSTIC_BUFFER_LEN);
-    }
+
+    /* populate basic diagnostic data of all the interfaces to buffer,
+     * from the published state snapshot as this runs on the service
+     * thread */
+    dump = intfd_dump_create(0, NULL, NULL);
+    intfd_dump_run(dump, &ds);
+    intfd_dump_destroy(dump);
+
+    *buf = ds_steal_cstr(&ds);
+    VLOG_INFO("basic diag-dump data populated for feature %s", feature);
     return;
 } /*intfd_diag_dump_basic_cb */
 
 static void
 intfd_init(const char *db_path)
 {
-    int retval;
-
     /* Initialize IDL through a new connection to the DB. */
     intfd_ovsdb_init(db_path);
 
     /* Register diagnostic callback function */
     INIT_DIAG_DUMP_BASIC(intfd_diag_dump_basic_cb);
 
-    retval = event_log_init("INTERFACE");
-    if(retval < 0) {
-        VLOG_ERR("Event log initialization failed for interface");
-    }
+    /* Start the event log writer. */
+    intfd_eventlog_init();
 
     /* Initialize the interface arbiter */
     intfd_arbiter_init();
 
-    /* Register ovs-appctl commands for this daemon. */
-    unixctl_command_register("ops-intfd/dump", "", 0, 1, intfd_unixctl_dump, NULL);
+    /* Start the interface evaluation threads. */
+    if (!eval_threads) {
+        eval_threads = MIN(count_cpu_cores(), INTFD_MAX_AUTO_EVAL_THREADS);
+    }
+    intfd_workers_init(eval_threads);
+
+    /* Register ovs-appctl commands for this daemon.  The ones that read or
+     * change the state of the main loop are run by it, the others by the
+     * service thread, see intfd_unixctl.c. */
+    unixctl_command_register("ops-intfd/dump",
+                             "[--json] [reason=R] [connector=C] "
+                             "[split=none|parent|child] [admin=up|down] "
+                             "[interface]",
+                             0, 6, intfd_unixctl_dump, NULL);
+    unixctl_command_register("ops-intfd/startup-stats", "", 0, 0,
+                             intfd_unixctl_startup_stats, NULL);
+    unixctl_command_register("ops-intfd/perf", "[reset]", 0, 1,
+                             intfd_unixctl_perf, NULL);
+    unixctl_command_register("ops-intfd/latency", "[interface]", 0, 1,
+                             intfd_unixctl_latency, NULL);
+    unixctl_command_register("ops-intfd/history", "interface", 1, 1,
+                             intfd_unixctl_history, NULL);
+    unixctl_command_register("ops-intfd/top", "[N] [10s|1m|5m]", 0, 2,
+                             intfd_unixctl_top, NULL);
+    intfd_unixctl_register_main("ops-intfd/record", "[FILE|stop]", 0, 1,
+                                intfd_unixctl_record, NULL);
+    unixctl_command_register("ops-intfd/eventlog", "", 0, 0,
+                             intfd_unixctl_eventlog, NULL);
+
+    if (record_file_name) {
+        char *error = NULL;
+
+        if (!intfd_record_start(record_file_name, &error)) {
+            VLOG_FATAL("--record: %s", error);
+        }
+    }
 } /* intfd_init */
 
 static void
 intfd_exit(void)
 {
+    intfd_record_stop();
+    free(record_file_name);
+    intfd_workers_exit();
+    intfd_eventlog_exit();
     intfd_ovsdb_exit();
 } /* intfd_exit */
 
+static void
+parse_fwd_damping(const char *arg)
+{
+    char *copy = xstrdup(arg);
+    char *save_ptr = NULL;
+    char *layer, *hold_down_s, *half_life_s;
+    unsigned int hold_down = 0, half_life = 0;
+
+    layer = strtok_r(copy, ":", &save_ptr);
+    hold_down_s = strtok_r(NULL, ":", &save_ptr);
+    half_life_s = strtok_r(NULL, ":", &save_ptr);
+
+    if (!layer || !hold_down_s || !str_to_uint(hold_down_s, 10, &hold_down)
+        || (half_life_s && !str_to_uint(half_life_s, 10, &half_life))) {
+        VLOG_FATAL("--fwd-damping argument must be LAYER:HOLD_DOWN[:HALF_LIFE]");
+    }
+    if (!intfd_arbiter_set_damping(layer, hold_down, half_life)) {
+        VLOG_FATAL("--fwd-damping: unknown forwarding layer %s", layer);
+    }
+    free(copy);
+} /* parse_fwd_damping */
+
 static char *
 parse_options(int argc, char *argv[], char **unixctl_pathp)
 {
     enum {
         OPT_UNIXCTL = UCHAR_MAX + 1,
+        OPT_TXN_MAX_ROWS,
+        OPT_EVAL_THREADS,
+        OPT_FWD_DAMPING,
+        OPT_RECORD,
         VLOG_OPTION_ENUMS,
         DAEMON_OPTION_ENUMS,
     };
     static const struct option long_options[] = {
         {"help",        no_argument, NULL, 'h'},
         {"unixctl",     required_argument, NULL, OPT_UNIXCTL},
+        {"txn-max-rows", required_argument, NULL, OPT_TXN_MAX_ROWS},
+        {"eval-threads", required_argument, NULL, OPT_EVAL_THREADS},
+        {"fwd-damping", required_argument, NULL, OPT_FWD_DAMPING},
+        {"record",      required_argument, NULL, OPT_RECORD},
         DAEMON_LONG_OPTIONS,
         VLOG_LONG_OPTIONS,
         {NULL, 0, NULL, 0},
     };
     char *short_options = long_options_to_short_options(long_options);
+    unsigned int txn_max_rows;
 
     for (;;) {
         int c;
@@ -191,6 +420,30 @@ parse_options(int argc, char *argv[], char **unixctl_pathp)
             *unixctl_pathp = optarg;
             break;
 
+        case OPT_TXN_MAX_ROWS:
+            if (!str_to_uint(optarg, 10, &txn_max_rows)) {
+                VLOG_FATAL("--txn-max-rows argument must be a non-negative "
+                           "integer");
+            }
+            intfd_set_txn_max_rows(txn_max_rows);
+            break;
+
+        case OPT_EVAL_THREADS:
+            if (!str_to_uint(optarg, 10, &eval_threads)) {
+                VLOG_FATAL("--eval-threads argument must be a non-negative "
+                           "integer");
+            }
+            break;
+
+        case OPT_FWD_DAMPING:
+            parse_fwd_damping(optarg);
+            break;
+
+        case OPT_RECORD:
+            /* Made absolute, as the daemon may change directory. */
+            record_file_name = abs_file_name(NULL, optarg);
+            break;
+
         VLOG_OPTION_HANDLERS
         DAEMON_OPTION_HANDLERS
 
@@ -219,13 +472,13 @@ parse_options(int argc, char *argv[], char **unixctl_pathp)
     }
 } /* parse_options */
 
-static void
-ops_intfd_exit(struct unixctl_conn *conn, int argc OVS_UNUSED,
-                  const char *argv[] OVS_UNUSED, void *exiting_)
+static bool
+ops_intfd_exit(int argc OVS_UNUSED, const char *argv[] OVS_UNUSED,
+               void *exiting_, struct ds *reply OVS_UNUSED)
 {
     bool *exiting = exiting_;
     *exiting = true;
-    unixctl_command_reply(conn, NULL);
+    return true;
 } /* ops_intfd_exit */
 
 int
@@ -258,7 +511,7 @@ main(int argc, char *argv[])
     }
 
     /* Register the ovs-appctl "exit" command for this daemon. */
-    unixctl_command_register("exit", "", 0, 0, ops_intfd_exit, &exiting);
+    intfd_unixctl_register_main("exit", "", 0, 0, ops_intfd_exit, &exiting);
 
     /* Create the IDL cache of the dB at ovsdb_sock. */
     intfd_init(ovsdb_sock);
@@ -267,6 +520,9 @@ main(int argc, char *argv[])
     /* Notify parent of startup completion. */
     daemonize_complete();
 
+    /* Serve ovs-appctl from its own thread from now on. */
+    intfd_unixctl_start(appctl);
+
     /* Enable asynch log writes to disk. */
     vlog_enable_async();
 
@@ -275,10 +531,11 @@ main(int argc, char *argv[])
     exiting = false;
     while (!exiting) {
         intfd_run();
-        unixctl_server_run(appctl);
+        intfd_perf_publish();
+        intfd_unixctl_run();
 
         intfd_wait();
-        unixctl_server_wait(appctl);
+        intfd_unixctl_wait();
         if (exiting) {
             poll_immediate_wake();
         } else {
@@ -286,6 +543,7 @@ main(int argc, char *argv[])
         }
     }
 
+    intfd_unixctl_stop();
     intfd_exit();
     unixctl_server_destroy(appctl);
 
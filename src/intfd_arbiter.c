@@ -14,468 +14,643 @@
  * under the License.
  */
 
+#include <inttypes.h>
+#include <coverage.h>
+#include <dynamic-string.h>
+#include <json.h>
 #include <smap.h>
+#include <util.h>
 #include <openvswitch/vlog.h>
 
 #include <openswitch-idl.h>
 #include <vswitch-idl.h>
 
 #include "intfd.h"
+#include "intfd_probes.h"
 
 VLOG_DEFINE_THIS_MODULE(intfd_arbiter);
 
-struct intfd_arbiter_class intfd_arbiter;
+COVERAGE_DEFINE(intfd_arbiter_block);
+COVERAGE_DEFINE(intfd_arbiter_unblock);
+COVERAGE_DEFINE(intfd_arbiter_held);
 
 /*!
- * @brief      A utility function to get the value associated with
- *             a given interface layer protocol.
+ * @brief      A utility function to translate the boolean
+ *             state value to string stored in OVSDB.
  *
- * @param[in]  proto    The enumeration value of the protocol.
+ * @param[in]  blocked    Boolean value to denote blocked or not.
  *
- * @return     The name associated with the protocol.
+ * @return     String associated with the forwarding state.
  */
 const char *
-intfd_arbiter_get_proto_name(enum ovsrec_interface_forwarding_state_proto_e proto)
+intfd_arbiter_get_state_value(bool blocked)
 {
-    switch (proto) {
-        case INTERFACE_FORWARDING_STATE_PROTO_LACP:
-            return INTERFACE_FORWARDING_STATE_PROTOCOL_LACP;
-        default:
-            return NULL;
-    }
+    return blocked ?
+            INTERFACE_FORWARDING_STATE_FORWARDING_FALSE:
+            INTERFACE_FORWARDING_STATE_FORWARDING_TRUE;
 }
 
 /*!
- * @brief      A utility function to get OVSDB key name for
- *             the forwarding state for a given layer.
+ * @brief      Function to determine the forwarding state of an interface
+ *             from "LACP" perspective.
  *
- * @param[in]  layer    The enumeration value of the layer.
+ * @param[in]  ifrow     The interface for which the arbiter is running.
  *
- * @return     The OVSDB key name associated with the layer.
+ * @return     true     If lacp deems the interface should be blocked.
+ *             false    If lacp deems the interface should be forwarding.
  */
-const char *
-intfd_arbiter_get_layer_key(enum ovsrec_interface_forwarding_state_layer_e layer)
+bool
+intfd_arbiter_lacp_state(const struct ovsrec_interface *ifrow)
 {
-    switch (layer) {
-        case INTERFACE_FORWARDING_STATE_LAYER_AGGREGATION:
-            return INTERFACE_FORWARDING_STATE_MAP_INTERFACE_AGGREGATION_FORWARDING;
-        default:
-            return NULL;
+    /* Get the forwarding state for this protocol. */
+    const char *bond_status;
+    bond_status = smap_get(&ifrow->bond_status, INTERFACE_BOND_STATUS_MAP_STATE);
+    if (!bond_status || STR_EQ(bond_status, INTERFACE_BOND_STATUS_UP)) {
+        return false;
+    } else {
+        return true;
     }
 }
 
+/* The protocols operating at the 'aggregation' layer.
+ * The ones listed first trump in precedence over the ones following it. */
+static const struct intfd_arbiter_proto_class intfd_arbiter_aggregation_protos[] = {
+    { INTERFACE_FORWARDING_STATE_PROTO_LACP,
+      INTERFACE_FORWARDING_STATE_PROTOCOL_LACP,
+      intfd_arbiter_lacp_state },
+};
+
+/* The forwarding layers applicable for an interface, from the first to the
+ * last in the hierarchy.  A layer is blocked if the layer before it is
+ * blocked. */
+static const struct intfd_arbiter_layer_class intfd_arbiter_layers[] = {
+    { INTERFACE_FORWARDING_STATE_LAYER_AGGREGATION,
+      "aggregation",
+      INTERFACE_FORWARDING_STATE_MAP_INTERFACE_AGGREGATION_FORWARDING,
+      INTERFACE_FORWARDING_STATE_MAP_INTERFACE_AGGREGATION_BLOCKED_REASON,
+      intfd_arbiter_aggregation_protos,
+      ARRAY_SIZE(intfd_arbiter_aggregation_protos) },
+};
+
+#define INTFD_ARBITER_N_LAYERS  ARRAY_SIZE(intfd_arbiter_layers)
+
+/* Flap damping parameters.  A layer accrues a penalty every time a protocol
+ * blocks it, which halves every 'half_life' ms.  Once the penalty exceeds
+ * the suppress threshold, the layer stays blocked until the penalty decays
+ * below the reuse threshold. */
+#define INTFD_ARBITER_FLAP_PENALTY              1000
+#define INTFD_ARBITER_SUPPRESS_THRESHOLD        2000
+#define INTFD_ARBITER_REUSE_THRESHOLD            750
+#define INTFD_ARBITER_MAX_PENALTY              16000
+
+/* The hysteresis configured for each forwarding layer, indexed by the
+ * position of the layer in the hierarchy.  All disabled by default. */
+static struct intfd_arbiter_damping intfd_arbiter_damping[INTFD_ARBITER_MAX_LAYERS];
+
 /*!
- * @brief      A utility function to get OVSDB key name for
- *             the asserting protocol for a given layer.
+ * @brief      A utility function to determine if the operator and hardware
+ *             ready state of an interface allow it to forward.
  *
- * @param[in]  layer    The enumeration value of the layer.
+ * @param[in]  ifrow     The interface for which the arbiter is running.
  *
- * @return     The OVSDB key name associated with the asserting
- *             protocol.
+ * @return     true     If the interface is up.
+ *             false    If the interface is down.
  */
-const char *
-intfd_arbiter_get_layer_owner_key(enum ovsrec_interface_forwarding_state_layer_e layer)
+static bool
+intfd_arbiter_oper_up(const struct ovsrec_interface *ifrow)
 {
-    switch (layer) {
-        case INTERFACE_FORWARDING_STATE_LAYER_AGGREGATION:
-            return INTERFACE_FORWARDING_STATE_MAP_INTERFACE_AGGREGATION_BLOCKED_REASON;
-        default:
-            return NULL;
+    const char *oper_state;
+#ifdef NOT_YET
+    const char *hw_status;
+#endif /* NOT_YET */
+
+    /* Get the operator state of the interface */
+    oper_state = smap_get(&ifrow->hw_intf_config,
+                          INTERFACE_HW_INTF_CONFIG_MAP_ENABLE);
+    if (!oper_state ||
+        !(STR_EQ(oper_state,
+                 INTERFACE_HW_INTF_CONFIG_MAP_ENABLE_TRUE))) {
+        return false;
+    }
+
+#ifdef NOT_YET
+    /* TODO: Enable this block once ACLs are ready */
+    /* Get the hw_status of the interface */
+    hw_status = smap_get(&ifrow->hw_status,
+                         "ready");
+    if (!hw_status ||
+        !(STR_EQ(hw_status,
+                 "true"))) {
+        return false;
     }
+#endif /* NOT_YET */
+
+    return true;
 }
 
 /*!
- * @brief      A utility function to translate the boolean
- *             state value to string stored in OVSDB.
+ * @brief      Function to collect the inputs of the arbiter for an interface:
+ *             its operator state and, for every forwarding layer, the bitmask
+ *             of the protocols asserting block. Bit N of the bitmask of a
+ *             layer is set if protos[N] of the layer deems the interface
+ *             should be blocked.
  *
- * @param[in]  blocked    Boolean value to denote blocked or not.
+ * @param[in]       ifrow     The interface for which the arbiter will run.
+ * @param[in,out]   state     The arbiter state of the interface.
+ * @param[in]       now       The current time, in ms.
  *
- * @return     String associated with the forwarding state.
+ * @return     true     If the inputs differ from the ones of the previous
+ *                      evaluation, the interface was never evaluated, its
+ *                      forwarding state column is stale or a hold timer
+ *                      of the interface expired.
+ *             false    If intfd_arbiter_interface_run() would not change
+ *                      anything.
  */
-const char *
-intfd_arbiter_get_state_value(bool blocked)
+bool
+intfd_arbiter_update_inputs(const struct ovsrec_interface *ifrow,
+                            struct intfd_arbiter_state *state,
+                            long long int now)
 {
-    return blocked ?
-            INTERFACE_FORWARDING_STATE_FORWARDING_FALSE:
-            INTERFACE_FORWARDING_STATE_FORWARDING_TRUE;
+    /* An expired hold timer counts as a change. */
+    bool changed = !state->evaluated || state->row_stale
+                   || (state->hold_until && now >= state->hold_until);
+    bool oper_up;
+    uint32_t asserting;
+    size_t i, j;
+
+    oper_up = intfd_arbiter_oper_up(ifrow);
+    if (oper_up != state->oper_up) {
+        state->oper_up = oper_up;
+        changed = true;
+    }
+
+    for (i = 0; i < INTFD_ARBITER_N_LAYERS; i++) {
+        const struct intfd_arbiter_layer_class *layer = &intfd_arbiter_layers[i];
+
+        asserting = 0;
+        for (j = 0; j < layer->n_protos; j++) {
+            if (layer->protos[j].get_state(ifrow)) {
+                asserting |= 1u << j;
+            }
+        }
+        if (asserting != state->asserting[i]) {
+            state->asserting[i] = asserting;
+            changed = true;
+        }
+    }
+
+    return changed;
 }
 
 /*!
- * @brief      A utility function to attach a new protocol to the existing list
- *             of protocols of a forwarding layer.
+ * @brief      A utility function to get the values of the OVSDB keys of a
+ *             forwarding layer for a given arbiter result.
  *
- * @param[in,out]  head     The head of the linked list of protocols.
- * @param[in]      proto    The new protocol to be attached to the list.
+ * @param[in]   result    The arbiter result.
+ * @param[in]   i         The position of the layer in the hierarchy.
+ * @param[out]  value     The forwarding state of the layer, or NULL if the
+ *                        key should be absent.
+ * @param[out]  owner     The asserting protocol of the layer, or NULL if the
+ *                        key should be absent.
  *
  * @return     Nothing
  */
-void
-intfd_arbiter_attach_proto(struct intfd_arbiter_proto_class **head,
-                           struct intfd_arbiter_proto_class *proto)
+static void
+intfd_arbiter_get_layer_values(const struct intfd_arbiter_result *result,
+                               size_t i, const char **value,
+                               const char **owner)
 {
-    struct intfd_arbiter_proto_class *node = *head;
-
-    /* If the head is null, list is empty. Return the current node as head */
-    if (node == NULL) {
-        *head = proto;
+    const struct intfd_arbiter_layer_class *layer = &intfd_arbiter_layers[i];
+
+    if (result->owned & (1u << i)) {
+        /* There is an owner. */
+        *value = intfd_arbiter_get_state_value(true);
+        *owner = layer->protos[result->owner[i]].name;
+    } else if (result->blocked & (1u << i)) {
+        /* The forwarding state is blocked without an owner. This implies:
+         * - The admin/operator state is down.
+         * - The forwarding state of a previous layer is blocked. */
+        *value = NULL;
+        *owner = NULL;
     } else {
-        /* Walk the list from head till we reach the last node */
-        while (node->next != NULL) {
-            node = node->next;
-        }
-        /* Attach the new node to the list */
-        node->next = proto;
+        /* The forwarding state is open. */
+        *value = intfd_arbiter_get_state_value(false);
+        *owner = NULL;
     }
 }
 
 /*!
- * @brief      A utility function to attach a new forwarding layer to the
- *             existing list forwarding layers for an interface.
+ * @brief      A utility function to update a single key of the forwarding
+ *             state column of OVSDB.
  *
- * @param[in,out]  head     The head of the linked list of forwarding layers.
- * @param[in]      layer    The new layer to be attached to the list.
+ * @param[in]  ifrow      The interface for which the arbiter is running.
+ * @param[in]  key        The key to update.
+ * @param[in]  value      The new value, or NULL to remove the key.
+ * @param[in]  old_value  The current value, or NULL if the key is absent.
  *
- * @return     Nothing
+ * @return     true     If the key was updated.
+ *             false    If the key already had the given value.
  */
-void
-intfd_arbiter_attach_layer(struct intfd_arbiter_layer_class **head,
-                           struct intfd_arbiter_layer_class *layer)
+static bool
+intfd_arbiter_update_key(const struct ovsrec_interface *ifrow,
+                         const char *key, const char *value,
+                         const char *old_value)
 {
-    struct intfd_arbiter_layer_class *node = *head;
+    if (value == old_value
+        || (value && old_value && !strcmp(value, old_value))) {
+        return false;
+    }
 
-    /* If the head is null, list is empty. Return the current node as head. */
-    if (node == NULL) {
-        *head = layer;
+    if (value) {
+        ovsrec_interface_update_forwarding_state_setkey(ifrow, key, value);
     } else {
-        /* Walk the list from head till we reach the last node */
-        while (node->next != NULL) {
-            node = node->next;
-        }
-        /* Attach the new node to the list and point it to the previous node */
-        node->next = layer;
-        layer->prev = node;
+        ovsrec_interface_update_forwarding_state_delkey(ifrow, key);
     }
+    return true;
 }
 
 /*!
- * @brief      Callback function to run the arbiter algorithm for a given
- *             protocol operating at a given layer of a given interface.
+ * @brief      A utility function to compute the flap penalty of a layer
+ *             decayed to the current time. The penalty halves every half
+ *             life, and decays linearly within a half life.
  *
- * @param[in]  proto     The pointer to the protocol data structure.
- * @param[in]  ifrow     The interface for which the arbiter is running.
+ * @param[in]  damping   The hysteresis configuration of the layer.
+ * @param[in]  hold      The hysteresis state of the layer.
+ * @param[in]  now       The current time, in ms.
  *
- * @return     true     If the current run deemed the forwarding state of the
- *                      interface layer to be blocked.
- *             false    If the current run deemed the forwarding state of the
- *                      interface layer to not be blocked.
+ * @return     The decayed penalty.
  */
-bool
-intfd_arbiter_proto_run(struct intfd_arbiter_proto_class *proto,
-                        const struct ovsrec_interface *ifrow)
+static uint32_t
+intfd_arbiter_decayed_penalty(const struct intfd_arbiter_damping *damping,
+                              const struct intfd_arbiter_hold *hold,
+                              long long int now)
 {
-    bool block;
-
-    /* Get the view of the forwarding state for the interface for
-     * the current protocol. */
-    block = (proto->get_state) ? proto->get_state(ifrow) : false;
-
-    if (block) {
-        /* Check if the current forwarding state of this layer is already
-         * blocked. */
-        if (proto->layer->blocked) {
-            /* Check if the current asserting protocol is of lower precedence
-             * than the current protocol.
-             * If yes, change the owner to current protocol. */
-            if (proto->id < proto->layer->owner) {
-                VLOG_DBG(
-                        "Changing owner of %d to %d for interface %s",
-                        proto->layer->id, proto->id, ifrow->name);
-                proto->layer->owner = proto->id;
-            }
-        } else {
-            VLOG_DBG(
-                    "Changing status of %d to blocked with owner as %d "
-                    "for interface %s",
-                    proto->layer->id, proto->id, ifrow->name);
-            /* Set the forwarding state for this layer to block and set the
-             * owner as current protocol. */
-            proto->layer->blocked = true;
-            proto->layer->owner = proto->id;
-        }
-    } else {
-        /* Check if the current forwarding state of this layer is
-         * already blocked. */
-        if (proto->layer->blocked) {
-            /* Check if current protocol is the current owner.
-             * If yes, clear the owner and move the state to forwarding. */
-            if (proto->id == proto->layer->owner) {
-                VLOG_DBG(
-                        "Changing status of %d to forwarding with owner %d "
-                        "cleared for interface %s",
-                        proto->layer->id, proto->id, ifrow->name);
-                proto->layer->owner = INTERFACE_FORWARDING_STATE_PROTO_NONE;
-                proto->layer->blocked = false;
-            }
-        }
+    long long int elapsed = now - hold->penalty_msec;
+    long long int half_lives = elapsed / damping->half_life;
+    uint32_t penalty = hold->penalty;
+
+    if (half_lives >= 32) {
+        penalty = 0;
+    } else if (elapsed > 0) {
+        penalty >>= half_lives;
+        penalty -= penalty * (elapsed % damping->half_life)
+                   / (2 * damping->half_life);
     }
+    return penalty;
+}
 
-    return block;
+/*!
+ * @brief      A utility function to decay the flap penalty of a layer to the
+ *             current time.
+ *
+ * @param[in]       damping   The hysteresis configuration of the layer.
+ * @param[in,out]   hold      The hysteresis state of the layer.
+ * @param[in]       now       The current time, in ms.
+ *
+ * @return     Nothing
+ */
+static void
+intfd_arbiter_decay_penalty(const struct intfd_arbiter_damping *damping,
+                            struct intfd_arbiter_hold *hold, long long int now)
+{
+    hold->penalty = intfd_arbiter_decayed_penalty(damping, hold, now);
+    hold->penalty_msec = now;
 }
 
 /*!
- * @brief      Callback function to run the arbiter algorithm for a given
- *             forwarding layer of a given interface.
+ * @brief      A utility function to compute how long the flap penalty of a
+ *             layer takes to decay to the reuse threshold.
  *
- * @param[in]       layer     The pointer to the f/w layer data structure.
- * @param[in]       ifrow     The interface for which the arbiter is running.
+ * @param[in]  damping   The hysteresis configuration of the layer.
+ * @param[in]  penalty   The current penalty.
  *
- * @return     true     If the current run deemed the forwarding state of the
- *                      interface layer to be blocked.
- *             false    If the current run deemed the forwarding state of the
- *                      interface layer to not be blocked.
+ * @return     The delay, in ms.
  */
-bool
-intfd_arbiter_layer_run(struct intfd_arbiter_layer_class *layer,
-                        const struct ovsrec_interface *ifrow)
+static long long int
+intfd_arbiter_reuse_delay(const struct intfd_arbiter_damping *damping,
+                          uint32_t penalty)
 {
-    struct intfd_arbiter_proto_class *proto;
-    bool block;
-    const char *oper_state;
-#ifdef NOT_YET
-    const char *hw_status;
-#endif /* NOT_YET */
+    long long int delay = 0;
 
-    /* Check if the forwarding state of the previous layer is blocked. */
-    if (layer->prev && layer->prev->blocked) {
-        /* Set the current layer as blocked and remove the owner. */
-        VLOG_DBG(
-                "Blocking %d for interface %s because forwarding layer "
-                "%d is blocked",
-                layer->id, ifrow->name, layer->prev->id);
-        layer->blocked = true;
-        layer->owner = INTERFACE_FORWARDING_STATE_PROTO_NONE;
-        return true;
+    while (penalty / 2 >= INTFD_ARBITER_REUSE_THRESHOLD) {
+        penalty /= 2;
+        delay += damping->half_life;
     }
-
-    /* Get the operator state of the interface */
-    oper_state = smap_get(&ifrow->hw_intf_config,
-                          INTERFACE_HW_INTF_CONFIG_MAP_ENABLE);
-    /* Block the interface if:
-     * a. The operator status of the interface is down.
-     * b. The hardware ready state of the interface is down.
-     */
-    if (!oper_state ||
-        !(STR_EQ(oper_state,
-                 INTERFACE_HW_INTF_CONFIG_MAP_ENABLE_TRUE))) {
-        /* Set the current layer as blocked and remove the owner. */
-        if (!layer->blocked) {
-            VLOG_DBG("Blocking %d for interface %s because the operator "
-                    "state is down", layer->id, ifrow->name);
-        }
-
-        layer->blocked = true;
-        layer->owner = INTERFACE_FORWARDING_STATE_PROTO_NONE;
-        return true;
+    if (penalty > INTFD_ARBITER_REUSE_THRESHOLD) {
+        /* Round up so that the penalty is below the threshold once the
+         * delay elapsed. */
+        delay += (2 * damping->half_life
+                  * (penalty - INTFD_ARBITER_REUSE_THRESHOLD)
+                  + penalty - 1) / penalty;
     }
+    return delay;
+}
 
-#ifdef NOT_YET
-    /* TODO: Enable this block once ACLs are ready */
-    /* Get the hw_status of the interface */
-    hw_status = smap_get(&ifrow->hw_status,
-                         "ready");
-    if (!hw_status ||
-        !(STR_EQ(hw_status,
-                 "true"))) {
-        /* Set the current layer as blocked and remove the owner. */
-        if (!layer->blocked) {
-            VLOG_DBG("Blocking %d for interface %s because the h/w status "
-                    "is blocked", layer->id, ifrow->name);
+/*!
+ * @brief      Function to account a protocol blocking a forwarding layer
+ *             that was forwarding.
+ *
+ * @param[in]       damping   The hysteresis configuration of the layer.
+ * @param[in,out]   hold      The hysteresis state of the layer.
+ * @param[in]       now       The current time, in ms.
+ *
+ * @return     Nothing
+ */
+static void
+intfd_arbiter_hold_block(const struct intfd_arbiter_damping *damping,
+                         struct intfd_arbiter_hold *hold, long long int now)
+{
+    hold->blocked_since = now;
+    hold->held = false;
+
+    if (damping->half_life) {
+        intfd_arbiter_decay_penalty(damping, hold, now);
+        hold->penalty = MIN(hold->penalty + INTFD_ARBITER_FLAP_PENALTY,
+                            INTFD_ARBITER_MAX_PENALTY);
+        if (hold->penalty >= INTFD_ARBITER_SUPPRESS_THRESHOLD) {
+            hold->suppressed = true;
         }
-
-        layer->blocked = true;
-        layer->owner = INTERFACE_FORWARDING_STATE_PROTO_NONE;
-        return true;
     }
-#endif /* NOT_YET */
+}
 
-    proto = layer->protos;
+/*!
+ * @brief      Function to determine when a forwarding layer blocked by a
+ *             protocol may move to forwarding once no protocol asserts
+ *             block anymore.
+ *
+ * @param[in]       damping   The hysteresis configuration of the layer.
+ * @param[in,out]   hold      The hysteresis state of the layer.
+ * @param[in]       now       The current time, in ms.
+ *
+ * @return     The time from which the layer may forward, in ms. The layer
+ *             may forward right away if it is not after 'now'.
+ */
+static long long int
+intfd_arbiter_hold_unblock(const struct intfd_arbiter_damping *damping,
+                           struct intfd_arbiter_hold *hold, long long int now)
+{
+    long long int when = hold->blocked_since + damping->hold_down;
 
-    /* Walk through all the protocols operating at this layer and determine the
-     * new forwarding state */
-    while (proto != NULL) {
-        if (proto->run) {
-            block = proto->run(proto, ifrow);
-            if (block) {
-                return true;
-            }
+    if (damping->half_life && hold->suppressed) {
+        intfd_arbiter_decay_penalty(damping, hold, now);
+        if (hold->penalty > INTFD_ARBITER_REUSE_THRESHOLD) {
+            when = MAX(when, now + intfd_arbiter_reuse_delay(damping,
+                                                             hold->penalty));
+        } else {
+            hold->suppressed = false;
         }
-        proto = proto->next;
     }
-
-    /* None of the protocols set the layer as blocking.
-     * Move the state to forwarding */
-    layer->blocked = false;
-    layer->owner = INTERFACE_FORWARDING_STATE_PROTO_NONE;
-
-    return false;
+    return when;
 }
 
 /*!
- * @brief      Function to run the arbiter algorithm for a given interface.
+ * @brief      Function to run the arbiter algorithm for a given interface,
+ *             based on the inputs collected by intfd_arbiter_update_inputs().
+ *
+ *             A layer is blocked without an owner if the previous layer is
+ *             blocked or the interface is down. Otherwise it is blocked if
+ *             any protocol asserts block, and the owner is the asserting
+ *             protocol of the highest precedence, i.e. the lowest set bit.
+ *
+ *             If the layer has a hysteresis configured, a layer blocked by
+ *             a protocol stays blocked, with the same owner, for at least
+ *             the hold down time, and for as long as its flap penalty is
+ *             suppressing it.
+ *
+ *             The result is compared with the one of the previous evaluation
+ *             and only the keys of the forwarding state column that changed
+ *             are written. On the first evaluation of the interface, and
+ *             while the column is stale, the result is compared with the
+ *             column itself.
  *
  * @param[in]       ifrow     The interface for which the arbiter is running.
- * @param[in,out]   forwarding_state The forwarding state column of OVSDB.
+ * @param[in,out]   state     The arbiter state of the interface.
+ * @param[in]       now       The current time, in ms.
  *
- * @return     Nothing
+ * @return     true     If the forwarding state column was updated.
+ *             false    If the forwarding state column is unchanged.
  */
-void
+bool
 intfd_arbiter_interface_run(const struct ovsrec_interface *ifrow,
-                            struct smap *forwarding_state)
+                            struct intfd_arbiter_state *state,
+                            long long int now)
 {
-    struct intfd_arbiter_layer_class *last_layer, *layer;
-    const char *layer_key, *layer_owner_key, *owner_name, *state_value;
-
-    last_layer = layer = intfd_arbiter.layers;
+    const struct intfd_arbiter_layer_class *layer;
+    const struct intfd_arbiter_damping *damping;
+    struct intfd_arbiter_hold *hold;
+    long long int unblock_msec;
+    bool was_owned;
+    struct intfd_arbiter_result result;
+    const char *value, *owner, *old_value, *old_owner;
+    bool blocked = !state->oper_up;
+    bool cached = state->evaluated && !state->row_stale;
+    bool value_updated, owner_updated, updated = false;
+    size_t i;
+
+    memset(&result, 0, sizeof result);
+    state->hold_until = 0;
 
     /* Walk from the first to last applicable forwarding layers for interface */
-    while (layer != NULL) {
-        /* Trigger the current layer checks if it has a registered function. */
-        if (layer->run) {
-            layer->run(layer, ifrow);
+    for (i = 0; i < INTFD_ARBITER_N_LAYERS; i++) {
+        layer = &intfd_arbiter_layers[i];
+        damping = &intfd_arbiter_damping[i];
+        hold = &state->holds[i];
+        was_owned = state->evaluated && (state->result.owned & (1u << i));
+
+        if (!blocked && state->asserting[i]) {
+            result.owned |= 1u << i;
+            result.owner[i] = raw_ctz(state->asserting[i]);
+            blocked = true;
+            if (!was_owned) {
+                COVERAGE_INC(intfd_arbiter_block);
+                intfd_arbiter_hold_block(damping, hold, now);
+            }
+        } else if (!blocked && was_owned) {
+            /* No protocol asserts block anymore. Keep the layer blocked by
+             * its last owner until the hysteresis allows it to forward. */
+            unblock_msec = intfd_arbiter_hold_unblock(damping, hold, now);
+            if (unblock_msec > now) {
+                result.owned |= 1u << i;
+                result.owner[i] = state->result.owner[i];
+                blocked = true;
+                if (!hold->held) {
+                    COVERAGE_INC(intfd_arbiter_held);
+                    VLOG_DBG("Holding %d for interface %s blocked for "
+                             "%lld ms", layer->id, ifrow->name,
+                             unblock_msec - now);
+                    hold->held = true;
+                    hold->n_suppressed++;
+                }
+                state->hold_until = (state->hold_until
+                                     ? MIN(state->hold_until, unblock_msec)
+                                     : unblock_msec);
+            } else {
+                COVERAGE_INC(intfd_arbiter_unblock);
+            }
+        }
+        if (blocked) {
+            result.blocked |= 1u << i;
         }
 
-        /* Get OVSDB key name for setting the forwarding state of the
-         * current layer */
-        layer_key = intfd_arbiter_get_layer_key(layer->id);
-        /* Get OVSDB key name for setting the owner for this layer dictating
-         * the forwarding state. */
-        layer_owner_key = intfd_arbiter_get_layer_owner_key(layer->id);
-        /* Get name for the current asserting owner for this layer */
-        owner_name = intfd_arbiter_get_proto_name(layer->owner);
-        /* Get the value associated with the forwarding state of the current
-         * layer */
-        state_value = intfd_arbiter_get_state_value(layer->blocked);
-
-        /* Check if the current layer has an owner */
-        if (layer->owner != INTERFACE_FORWARDING_STATE_PROTO_NONE) {
-            /* There is an owner. Set the forwarding state and the owner
-             * for this layer based on the information cached in the layer
-             * data structure. */
-            smap_replace(forwarding_state, layer_key, state_value);
-            smap_replace(forwarding_state, layer_owner_key, owner_name);
+        intfd_arbiter_get_layer_values(&result, i, &value, &owner);
+        if (cached) {
+            intfd_arbiter_get_layer_values(&state->result, i,
+                                           &old_value, &old_owner);
         } else {
-            /* There is no owner. Check if the current forwarding state of
-             * the layer is blocked. */
-            if (layer->blocked) {
-                /* The forwarding state is blocked. This implies:
-                 * - The admin/operator state is down.
-                 * - The forwarding state of a previous layer is blocked.
-                 *
-                 * Remove the key,value pair for the forwarding state of this
-                 * layer and the asserting protocol. */
-                smap_remove(forwarding_state, layer_key);
-                smap_remove(forwarding_state, layer_owner_key);
-            } else {
-                /* The forwarding state is open. Set the forwarding state as
-                 * open for current layer and remove any asserting protocol. */
-                smap_replace(forwarding_state, layer_key, state_value);
-                smap_remove(forwarding_state, layer_owner_key);
-            }
+            old_value = smap_get(&ifrow->forwarding_state, layer->key);
+            old_owner = smap_get(&ifrow->forwarding_state, layer->owner_key);
         }
 
-        /* Move to the next forwarding layer in the hierarchy */
-        last_layer = layer;
-        layer = layer->next;
+        value_updated = intfd_arbiter_update_key(ifrow, layer->key,
+                                                 value, old_value);
+        owner_updated = intfd_arbiter_update_key(ifrow, layer->owner_key,
+                                                 owner, old_owner);
+        if (value_updated || owner_updated) {
+            VLOG_DBG("Forwarding state of %d for interface %s is %s, "
+                     "owner %s", layer->id, ifrow->name,
+                     value ? value : "blocked", owner ? owner : "none");
+            updated = true;
+        }
     }
 
     /* Set the forwarding state of the interface based on the forwarding state
-     * of the last layer.
-     * If there isn't one, set the interface state as forwarding. */
-    if (last_layer) {
-        state_value = intfd_arbiter_get_state_value(last_layer->blocked);
-        smap_replace(forwarding_state, INTERFACE_FORWARDING_STATE_MAP_FORWARDING,
-                     state_value);
+     * of the last layer. */
+    value = intfd_arbiter_get_state_value(blocked);
+    if (cached) {
+        old_value = intfd_arbiter_get_state_value(
+                state->result.blocked & (1u << (INTFD_ARBITER_N_LAYERS - 1)));
     } else {
-        smap_replace(forwarding_state, INTERFACE_FORWARDING_STATE_MAP_FORWARDING,
-                     INTERFACE_FORWARDING_STATE_FORWARDING_TRUE);
+        old_value = smap_get(&ifrow->forwarding_state,
+                             INTERFACE_FORWARDING_STATE_MAP_FORWARDING);
     }
+    updated |= intfd_arbiter_update_key(ifrow,
+                                        INTERFACE_FORWARDING_STATE_MAP_FORWARDING,
+                                        value, old_value);
+
+    if (updated) {
+        INTFD_PROBE3(arbiter_decision, ifrow->name, result.blocked,
+                     result.owned);
+    }
+
+    state->result = result;
+    state->evaluated = true;
+    state->row_stale = false;
+
+    return updated;
 }
 
 /*!
- * @brief      Function to determine the forwarding state of an interface
- *             from "LACP" perspective.
+ * @brief      Function to configure the hysteresis of a forwarding layer.
  *
- * @param[in]  ifrow     The interface for which the arbiter is running.
+ * @param[in]  layer_name   The name of the layer, e.g. "aggregation".
+ * @param[in]  hold_down    The minimum time a layer blocked by a protocol
+ *                          stays blocked, in ms. 0 to disable.
+ * @param[in]  half_life    The half life of the flap penalty, in ms. 0 to
+ *                          disable flap damping.
  *
- * @return     true     If lacp deems the interface should be blocked.
- *             false    If lacp deems the interface should be forwarding.
+ * @return     true     If the layer exists.
+ *             false    Otherwise.
  */
 bool
-intfd_arbiter_lacp_state(const struct ovsrec_interface *ifrow)
+intfd_arbiter_set_damping(const char *layer_name, long long int hold_down,
+                          long long int half_life)
 {
-    /* Get the forwarding state for this protocol. */
-    const char *bond_status;
-    bond_status = smap_get(&ifrow->bond_status, INTERFACE_BOND_STATUS_MAP_STATE);
-    if (!bond_status || STR_EQ(bond_status, INTERFACE_BOND_STATUS_UP)) {
-        return false;
-    } else {
-        return true;
+    size_t i;
+
+    for (i = 0; i < INTFD_ARBITER_N_LAYERS; i++) {
+        if (!strcmp(intfd_arbiter_layers[i].name, layer_name)) {
+            intfd_arbiter_damping[i].hold_down = hold_down;
+            intfd_arbiter_damping[i].half_life = half_life;
+            return true;
+        }
     }
+    return false;
 }
 
 /*!
- * @brief      Function to register the forwarding layer 'aggregation' and all
- *             the applicable protocols at this layer with the arbiter.
+ * @brief      Function to dump the hysteresis state of an interface for
+ *             debugging.
  *
- * @param[in,out]  layer_head     The head of the linked list of forwarding
- *                                layers.
+ * @param[in,out]   ds        The buffer to dump to.
+ * @param[in]       state     The arbiter state of the interface.
+ * @param[in]       now       The current time, in ms.
  *
  * @return     Nothing
  */
 void
-intfd_arbiter_layer_aggregation_register(
-        struct intfd_arbiter_layer_class **layer_head)
+intfd_arbiter_dump_holds(struct ds *ds,
+                         const struct intfd_arbiter_state *state,
+                         long long int now)
 {
-    struct intfd_arbiter_layer_class *aggregation;
-    struct intfd_arbiter_proto_class *proto, *proto_head = NULL;
-
-    /* Define and register the aggregation layer */
-    aggregation = xzalloc(sizeof(struct intfd_arbiter_layer_class));
-    if (aggregation == NULL) {
-        VLOG_ERR("Failed to register aggregation layer - "
-                 "Memory allocation failed.");
-        return;
-    }
-    aggregation->id = INTERFACE_FORWARDING_STATE_LAYER_AGGREGATION;
-    aggregation->owner = INTERFACE_FORWARDING_STATE_PROTO_NONE;
-    aggregation->run = intfd_arbiter_layer_run;
-    aggregation->next = NULL;
-    aggregation->prev = NULL;
-
-    /* Define and register the protocols running at aggregation layer.
-     * The ones registered first trumps in precedence over the
-     * ones following it. */
-
-    /* Register LACP */
-    proto = xzalloc(sizeof(struct intfd_arbiter_proto_class));
-    if (proto == NULL) {
-        VLOG_ERR("Failed to register proto class for aggregation layer - "
-                 "Memory allocation failed.");
-        return;
-    }
-    proto->id = INTERFACE_FORWARDING_STATE_PROTO_LACP;
-    proto->run = intfd_arbiter_proto_run;
-    proto->get_state = intfd_arbiter_lacp_state;
-    proto->layer = aggregation;
-    proto->next = NULL;
-    intfd_arbiter_attach_proto(&proto_head, proto);
+    const struct intfd_arbiter_damping *damping;
+    const struct intfd_arbiter_hold *hold;
+    uint32_t penalty;
+    size_t i;
+
+    for (i = 0; i < INTFD_ARBITER_N_LAYERS; i++) {
+        damping = &intfd_arbiter_damping[i];
+        hold = &state->holds[i];
+        if (!damping->hold_down && !damping->half_life) {
+            continue;
+        }
 
-    aggregation->protos = proto_head;
+        /* Only for display: the state may be shared with other threads. */
+        penalty = hold->penalty;
+        if (damping->half_life) {
+            penalty = intfd_arbiter_decayed_penalty(damping, hold, now);
+        }
+        ds_put_format(ds, "    %-19s: penalty %"PRIu32"%s, %"PRIu32
+                      " suppressed\n", intfd_arbiter_layers[i].name,
+                      penalty, hold->suppressed ? " (suppressing)" : "",
+                      hold->n_suppressed);
+    }
+}
 
-    /* Attach the health layer to the list */
-    intfd_arbiter_attach_layer(layer_head, aggregation);
+/*!
+ * @brief      Function to dump the hysteresis state of an interface as
+ *             JSON, with the same content as intfd_arbiter_dump_holds().
+ *
+ * @param[in]  state     The arbiter state of the interface.
+ * @param[in]  now       The current time, in ms.
+ *
+ * @return     An object with a member per damped layer, or NULL if no
+ *             layer is damped.
+ */
+struct json *
+intfd_arbiter_dump_holds_json(const struct intfd_arbiter_state *state,
+                              long long int now)
+{
+    const struct intfd_arbiter_damping *damping;
+    const struct intfd_arbiter_hold *hold;
+    struct json *holds = NULL;
+    struct json *layer;
+    uint32_t penalty;
+    size_t i;
+
+    for (i = 0; i < INTFD_ARBITER_N_LAYERS; i++) {
+        damping = &intfd_arbiter_damping[i];
+        hold = &state->holds[i];
+        if (!damping->hold_down && !damping->half_life) {
+            continue;
+        }
 
-    return;
+        penalty = hold->penalty;
+        if (damping->half_life) {
+            penalty = intfd_arbiter_decayed_penalty(damping, hold, now);
+        }
+        layer = json_object_create();
+        json_object_put(layer, "penalty", json_integer_create(penalty));
+        json_object_put(layer, "suppressing",
+                        json_boolean_create(hold->suppressed));
+        json_object_put(layer, "suppressed",
+                        json_integer_create(hold->n_suppressed));
+
+        if (!holds) {
+            holds = json_object_create();
+        }
+        json_object_put(holds, intfd_arbiter_layers[i].name, layer);
+    }
+    return holds;
 }
 
 /*!
@@ -486,10 +661,16 @@ intfd_arbiter_layer_aggregation_register(
 void
 intfd_arbiter_init(void)
 {
-    memset(&intfd_arbiter, 0, sizeof(struct intfd_arbiter_class));
-
-    /* Initialize and attach the interface 'aggregation' layer */
-    intfd_arbiter_layer_aggregation_register(&intfd_arbiter.layers);
+    size_t i;
+
+    /* The per-interface state has room for a limited number of layers and
+     * protocols per layer. */
+    BUILD_ASSERT(ARRAY_SIZE(intfd_arbiter_layers) > 0);
+    BUILD_ASSERT(ARRAY_SIZE(intfd_arbiter_layers) <= INTFD_ARBITER_MAX_LAYERS);
+    for (i = 0; i < INTFD_ARBITER_N_LAYERS; i++) {
+        ovs_assert(intfd_arbiter_layers[i].n_protos
+                   <= INTFD_ARBITER_MAX_PROTOS);
+    }
 
     return;
 }
@@ -0,0 +1,267 @@
+/*
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+/************************************************************************//**
+ * @ingroup intfd
+ *
+ * @file
+ * Source for the asynchronous event log writer of ops-intfd.
+ *
+ * The main thread posts INTERFACE_UP and INTERFACE_DOWN events into a
+ * bounded single producer, single consumer ring, without locking.  A
+ * logger thread wakes up when an event is posted to an empty ring, waits
+ * INTFD_EVENTLOG_WINDOW_MS for the rest of the burst, then takes every
+ * queued event and writes them to the event log in one batch.  Within a
+ * batch, an event repeated for an interface with no other event for it in
+ * between is logged once.  When the ring is full, events are dropped and
+ * counted rather than blocking the main thread.
+ *
+ ***************************************************************************/
+
+#include <pthread.h>
+#include <string.h>
+
+#include <config.h>
+#include <coverage.h>
+#include <dynamic-string.h>
+#include <ovs-atomic.h>
+#include <ovs-thread.h>
+#include <poll-loop.h>
+#include <seq.h>
+#include <shash.h>
+#include <util.h>
+#include <openvswitch/vlog.h>
+
+#include "eventlog.h"
+#include "intfd_eventlog.h"
+
+VLOG_DEFINE_THIS_MODULE(intfd_eventlog);
+
+COVERAGE_DEFINE(intfd_event_dropped);
+
+/** @ingroup intfd
+ * @{ */
+
+/* Number of entries of the ring, a power of 2. */
+#define INTFD_EVENTLOG_QUEUE_LEN    4096
+
+/* Longer interface names are truncated in the event log. */
+#define INTFD_EVENTLOG_NAME_LEN     64
+
+/* Time the logger waits for a burst of events to be posted. */
+#define INTFD_EVENTLOG_WINDOW_MS    100
+
+struct intfd_eventlog_entry {
+    enum intfd_event event;
+    char name[INTFD_EVENTLOG_NAME_LEN];
+};
+
+static const char *event_names[INTFD_N_EVENTS] = {
+    [INTFD_EVENT_INTERFACE_UP]      = "INTERFACE_UP",
+    [INTFD_EVENT_INTERFACE_DOWN]    = "INTERFACE_DOWN",
+};
+
+static struct intfd_eventlog_entry queue[INTFD_EVENTLOG_QUEUE_LEN];
+static atomic_uint64_t queue_head;  /* Next entry to log, logger only. */
+static atomic_uint64_t queue_tail;  /* Next free entry, main thread only. */
+static struct seq *queue_seq;       /* Changed when the ring stops being
+                                     * empty, and on exit. */
+static atomic_bool exiting;
+static pthread_t logger;
+static bool logger_running;
+
+/* Each counter has a single writer, see intfd_eventlog_dump(). */
+static atomic_count n_posted;
+static atomic_count n_dropped;
+static atomic_count max_depth;
+static atomic_count n_logged;
+static atomic_count n_coalesced;
+static atomic_count n_batches;
+
+/* Logs 'n' events of 'batch', coalescing the repeated ones. */
+static void
+intfd_eventlog_flush(const struct intfd_eventlog_entry *batch, size_t n)
+{
+    struct shash last = SHASH_INITIALIZER(&last);
+    const struct intfd_eventlog_entry *entry, *prev;
+    struct shash_node *node;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        entry = &batch[i];
+        node = shash_find(&last, entry->name);
+        if (node) {
+            prev = node->data;
+            if (prev->event == entry->event) {
+                atomic_count_inc(&n_coalesced);
+                continue;
+            }
+            node->data = CONST_CAST(struct intfd_eventlog_entry *, entry);
+        } else {
+            shash_add(&last, entry->name,
+                      CONST_CAST(struct intfd_eventlog_entry *, entry));
+        }
+
+        log_event(event_names[entry->event],
+                  EV_KV("interface", entry->name));
+        atomic_count_inc(&n_logged);
+    }
+    atomic_count_inc(&n_batches);
+
+    shash_destroy(&last);
+} /* intfd_eventlog_flush */
+
+static void *
+intfd_eventlog_main(void *arg OVS_UNUSED)
+{
+    struct intfd_eventlog_entry *batch;
+    uint64_t head, tail, seqno, i;
+    bool stop;
+
+    batch = xmalloc(INTFD_EVENTLOG_QUEUE_LEN * sizeof *batch);
+    for (;;) {
+        /* Read before checking the ring, so that a post to the ring just
+         * emptied wakes us up. */
+        seqno = seq_read(queue_seq);
+        atomic_read_explicit(&queue_head, &head, memory_order_relaxed);
+        atomic_read_explicit(&queue_tail, &tail, memory_order_acquire);
+        atomic_read_relaxed(&exiting, &stop);
+
+        if (head == tail) {
+            if (stop) {
+                break;
+            }
+            seq_wait(queue_seq, seqno);
+            poll_block();
+            continue;
+        }
+
+        if (!stop) {
+            poll_timer_wait(INTFD_EVENTLOG_WINDOW_MS);
+            poll_block();
+            atomic_read_explicit(&queue_tail, &tail, memory_order_acquire);
+        }
+
+        /* Copy the events out, so that the ring is free again before the
+         * slow part. */
+        for (i = head; i != tail; i++) {
+            batch[i - head] = queue[i & (INTFD_EVENTLOG_QUEUE_LEN - 1)];
+        }
+        atomic_store_explicit(&queue_head, tail, memory_order_release);
+
+        intfd_eventlog_flush(batch, tail - head);
+    }
+    free(batch);
+
+    return NULL;
+} /* intfd_eventlog_main */
+
+/* Initializes the "INTERFACE" event log category and starts the logger
+ * thread. */
+void
+intfd_eventlog_init(void)
+{
+    if (event_log_init("INTERFACE") < 0) {
+        VLOG_ERR("Event log initialization failed for interface");
+    }
+
+    atomic_init(&queue_head, 0);
+    atomic_init(&queue_tail, 0);
+    atomic_init(&exiting, false);
+    queue_seq = seq_create();
+    logger = ovs_thread_create("intfd_eventlog", intfd_eventlog_main, NULL);
+    logger_running = true;
+} /* intfd_eventlog_init */
+
+/* Stops the logger thread once it has logged every posted event. */
+void
+intfd_eventlog_exit(void)
+{
+    if (!logger_running) {
+        return;
+    }
+
+    atomic_store_relaxed(&exiting, true);
+    seq_change(queue_seq);
+    xpthread_join(logger, NULL);
+    logger_running = false;
+    seq_destroy(queue_seq);
+    queue_seq = NULL;
+} /* intfd_eventlog_exit */
+
+/* Posts 'event' for 'intf_name' to the logger thread.  Must be called from
+ * the main thread.  Without a logger thread, the event is logged right
+ * away. */
+void
+intfd_eventlog_post(enum intfd_event event, const char *intf_name)
+{
+    static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+    struct intfd_eventlog_entry *entry;
+    uint64_t head, tail;
+    unsigned int depth;
+
+    if (!logger_running) {
+        log_event(event_names[event], EV_KV("interface", intf_name));
+        return;
+    }
+
+    atomic_read_explicit(&queue_head, &head, memory_order_acquire);
+    atomic_read_explicit(&queue_tail, &tail, memory_order_relaxed);
+    if (tail - head >= INTFD_EVENTLOG_QUEUE_LEN) {
+        COVERAGE_INC(intfd_event_dropped);
+        atomic_count_inc(&n_dropped);
+        VLOG_WARN_RL(&rl, "Event log queue full, dropped %s for %s",
+                     event_names[event], intf_name);
+        return;
+    }
+
+    entry = &queue[tail & (INTFD_EVENTLOG_QUEUE_LEN - 1)];
+    entry->event = event;
+    ovs_strzcpy(entry->name, intf_name, sizeof entry->name);
+    atomic_store_explicit(&queue_tail, tail + 1, memory_order_release);
+
+    atomic_count_inc(&n_posted);
+    depth = tail + 1 - head;
+    if (depth > atomic_count_get(&max_depth)) {
+        atomic_count_set(&max_depth, depth);
+    }
+    if (tail == head) {
+        seq_change(queue_seq);
+    }
+} /* intfd_eventlog_post */
+
+/* Appends the state and the counters of the event log writer to 'ds'. */
+void
+intfd_eventlog_dump(struct ds *ds)
+{
+    uint64_t head, tail;
+
+    atomic_read_relaxed(&queue_head, &head);
+    atomic_read_relaxed(&queue_tail, &tail);
+
+    ds_put_format(ds, "Logger thread      %s\n",
+                  logger_running ? "running" : "not running");
+    ds_put_format(ds, "Queue depth        %"PRIu64"/%d (max %u)\n",
+                  tail - head, INTFD_EVENTLOG_QUEUE_LEN,
+                  atomic_count_get(&max_depth));
+    ds_put_format(ds, "Posted             %u\n", atomic_count_get(&n_posted));
+    ds_put_format(ds, "Dropped            %u\n", atomic_count_get(&n_dropped));
+    ds_put_format(ds, "Logged             %u\n", atomic_count_get(&n_logged));
+    ds_put_format(ds, "Coalesced          %u\n",
+                  atomic_count_get(&n_coalesced));
+    ds_put_format(ds, "Batches            %u\n", atomic_count_get(&n_batches));
+} /* intfd_eventlog_dump */
+
+/** @} end of group intfd */
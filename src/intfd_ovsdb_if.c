@@ -33,12 +33,16 @@
 #include <config.h>
 #include <command-line.h>
 #include <compiler.h>
+#include <coverage.h>
 #include <daemon.h>
 #include <dirs.h>
 #include <dynamic-string.h>
 #include <fatal-signal.h>
+#include <ovs-atomic.h>
+#include <ovs-rcu.h>
 #include <ovsdb-idl.h>
 #include <poll-loop.h>
+#include <timeval.h>
 #include <unixctl.h>
 #include <util.h>
 #include <openvswitch/vconn.h>
@@ -46,15 +50,32 @@
 #include <vswitch-idl.h>
 #include <openswitch-idl.h>
 #include <hash.h>
+#include <hmap.h>
+#include <json.h>
 #include <shash.h>
 
 #include "intfd.h"
+#include "intfd_perf.h"
+#include "intfd_probes.h"
+#include "intfd_record.h"
 #include "intfd_utils.h"
+#include "intfd_workers.h"
 
-#include "eventlog.h"
+#include "intfd_eventlog.h"
 
 VLOG_DEFINE_THIS_MODULE(intfd_ovsdb_if);
 
+COVERAGE_DEFINE(intfd_intf_added);
+COVERAGE_DEFINE(intfd_intf_deleted);
+COVERAGE_DEFINE(intfd_cfg_changed);
+COVERAGE_DEFINE(intfd_pm_info_changed);
+COVERAGE_DEFINE(intfd_split_propagated);
+COVERAGE_DEFINE(intfd_write_emitted);
+COVERAGE_DEFINE(intfd_write_suppressed);
+COVERAGE_DEFINE(intfd_port_admin_changed);
+COVERAGE_DEFINE(intfd_port_member_removed);
+COVERAGE_DEFINE(intfd_mtu_rescan);
+
 /** @ingroup intfd
  * @{ */
 static struct ovsdb_idl *idl;
@@ -63,6 +84,129 @@ static unsigned int idl_seqno;
 
 static bool system_configured = false;
 
+/* Set for the run that processes the rows re-sent by a new session with
+ * ovsdb-server, which reconciles them against the locally cached
+ * interface and port state. */
+static bool idl_resync = false;
+
+/* True while System:cur_cfg is still 0.  Rows are parsed and evaluated as
+ * they arrive, but nothing is written until the system is configured. */
+static bool intfd_staging = true;
+
+/* Boot-time statistics, reported by "ops-intfd/startup-stats". */
+struct intfd_startup_stats {
+    long long int cur_cfg_msec;        /* When System:cur_cfg became > 0. */
+    long long int first_commit_msec;   /* When the prepared commit completed. */
+    size_t n_staged;                   /* Writes queued before that. */
+    size_t n_written;                  /* Rows written by the prepared commit. */
+    unsigned int n_txns;               /* Transactions used for them. */
+};
+
+static struct intfd_startup_stats startup_stats;
+
+/* The transaction that writes go to.  Once 'txn_max_rows' interface rows
+ * have been written to it, it is committed and replaced by a new one, so
+ * that a mass event does not turn into a single huge transaction.  0 means
+ * no limit. */
+static struct ovsdb_idl_txn *intfd_txn;
+static unsigned int txn_max_rows = INTFD_DEFAULT_TXN_MAX_ROWS;
+static unsigned int txn_rows;
+static unsigned int txn_chunks;
+
+/* Interfaces with a configuration change written to 'intfd_txn', whose
+ * config to hardware latency completes when it commits. */
+static struct iface **txn_inflight;
+static size_t n_txn_inflight, allocated_txn_inflight;
+
+/* Interfaces whose forwarding state was written to 'intfd_txn'.  Their
+ * arbiter state is marked stale if it fails to commit. */
+static struct iface **txn_arbiter;
+static size_t n_txn_arbiter, allocated_txn_arbiter;
+
+/* Config to hardware latency of all interfaces, and the slowest
+ * transitions seen. */
+#define INTFD_N_SLOWEST_TRANSITIONS     10
+
+struct intfd_transition {
+    char *name;
+    long long int latency;              /* In ns. */
+    unsigned int seqno;                 /* IDL seqno the change was seen at. */
+    long long int when;                 /* Wall clock time of the commit. */
+};
+
+static struct intfd_perf_histogram cfg_latency;
+static struct intfd_transition slowest[INTFD_N_SLOWEST_TRANSITIONS];
+static size_t n_slowest;
+static unsigned int n_failed_transitions;
+
+/* Number of op state transitions kept per interface. */
+#define INTFD_HISTORY_LEN               16
+
+/* The inputs whose change led to an evaluation. */
+enum intfd_trigger {
+    INTFD_TRIGGER_ADDED         = 1 << 0,   /* Row inserted. */
+    INTFD_TRIGGER_USER_CONFIG   = 1 << 1,
+    INTFD_TRIGGER_PM_INFO       = 1 << 2,
+    INTFD_TRIGGER_PORT          = 1 << 3,   /* Port admin or membership. */
+    INTFD_TRIGGER_SPLIT         = 1 << 4,   /* Own or parent lane split. */
+    INTFD_TRIGGER_SUBSYSTEM     = 1 << 5,   /* Subsystem MTU. */
+};
+
+static const char *trigger_names[] = {
+    "added", "user_config", "pm_info", "port", "split", "subsystem",
+};
+
+/* A change of the op state of an interface. */
+struct intfd_history_entry {
+    long long int when;                 /* Monotonic, in ns. */
+    enum ovsrec_interface_error_e old_reason;
+    enum ovsrec_interface_error_e new_reason;
+    unsigned int triggers;              /* INTFD_TRIGGER_*. */
+};
+
+/* The CPU cost of an interface is accounted in buckets of 10 s, enough of
+ * them to cover the longest window of intfd_top_dump() plus the current
+ * bucket. */
+#define INTFD_COST_BUCKET_NS            10000000000LL
+#define INTFD_COST_N_BUCKETS            31
+
+struct intfd_cost_bucket {
+    unsigned long long int eval_ns;     /* Time spent evaluating. */
+    unsigned int n_evals;
+    unsigned int n_writes;              /* Rows written, hardware
+                                         * configuration and forwarding
+                                         * state. */
+};
+
+/* The cost of an interface, see intfd_cost_current(). */
+struct intfd_cost {
+    long long int epoch;                /* Of the last bucket charged. */
+    struct intfd_cost_bucket buckets[INTFD_COST_N_BUCKETS];
+};
+
+/* Bucket charged by the current iteration of the main loop. */
+static long long int cost_epoch;
+
+/* Interfaces whose evaluated state has to be written to OVSDB, in the
+ * order they were evaluated.  Slots of deleted or re-queued interfaces
+ * are NULL. */
+static struct iface **pending_writes;
+static size_t n_pending_writes, allocated_pending_writes;
+
+/* Interfaces whose arbiter inputs may have changed.  Slots of deleted
+ * interfaces are NULL. */
+static struct iface **pending_arbiter;
+static size_t n_pending_arbiter, allocated_pending_arbiter;
+
+/* Earliest time at which a forwarding layer held blocked by the arbiter
+ * hysteresis may forward, 0 if none is held. */
+static long long int arbiter_hold_until;
+
+/* When the interfaces whose forwarding state failed to commit are queued
+ * for the arbiter again, 0 if none failed. */
+#define INTFD_ARBITER_RETRY_MSEC        1000
+static long long int arbiter_retry_at;
+
 /* Mapping of all the interfaces. */
 static struct shash all_interfaces = SHASH_INITIALIZER(&all_interfaces);
 
@@ -122,6 +266,53 @@ struct iface {
     struct iface                *split_parent;
     struct iface                **split_children;
     int                         n_split_children;
+    struct iface_slab           *slab;      /* Set if bulk-loaded. */
+
+    /* Pending evaluation and write, see intfd_queue_write(). */
+    bool                        eval_pending;
+    bool                        write_pending;
+    bool                        reset_pending;  /* See intfd_queue_reset(). */
+    size_t                      pending_idx;
+    struct uuid                 row_uuid;
+
+    /* Pending forwarding state arbitration, see intfd_queue_arbiter(). */
+    bool                        arbiter_pending;
+    size_t                      arbiter_idx;
+    struct intfd_arbiter_state  arbiter;
+
+    /* Config to hardware latency, see intfd_latency_observe(). */
+    long long int               cfg_observed;   /* 0 if none in flight. */
+    unsigned int                cfg_seqno;
+    unsigned long long int      cfg_n_latency;
+    long long int               cfg_last_latency;
+    long long int               cfg_max_latency;
+    unsigned long long int      cfg_total_latency;
+
+    /* Op state transitions, in a ring, see intfd_history_record(). */
+    unsigned int                eval_triggers;  /* Since last evaluation. */
+    unsigned long long int      n_history;      /* Recorded so far. */
+    struct intfd_history_entry  history[INTFD_HISTORY_LEN];
+
+    /* Published state, see intfd_snapshot_publish(). */
+    struct intfd_snapshot_intf  *snap;          /* NULL until published. */
+    bool                        snap_dirty;
+
+    /* CPU cost, see intfd_cost_current(). */
+    struct intfd_cost           *cost;          /* NULL until charged. */
+};
+
+/* A block of interfaces allocated together by intfd_bulk_load().
+ * Freed once the last interface in it has been deleted. */
+struct iface_slab {
+    size_t          n_live;
+    struct iface    ifaces[];
+};
+
+/* Row to interface mapping used while bulk-loading. */
+struct iface_row_ref {
+    struct hmap_node                node;   /* In a map hashed on 'row'. */
+    const struct ovsrec_interface   *row;
+    struct iface                    *intf;
 };
 
 struct port_info {
@@ -174,96 +365,599 @@ typedef struct subsystem {
 subsystem_t                     base_subsys = {0};
 
 static void del_old_interface(struct shash_node *sh_node);
+static void intfd_queue_reset(struct iface *intf,
+                              const struct ovsrec_interface *ifrow);
 
-void set_interface_config(const struct ovsrec_interface *ifrow, struct iface *intf);
+void set_interface_config(const struct ovsrec_interface *ifrow,
+                          struct iface *intf, unsigned int triggers);
 int remove_interface_from_port(const struct ovsrec_port *port_row);
 
+/* The published state of an interface.  It is immutable, and shared by
+ * every snapshot published while the interface did not change. */
+struct intfd_snapshot_intf {
+    struct ovs_refcount         ref_cnt;    /* The interface, snapshots. */
+    char                        *name;
+    char                        *split_parent;      /* NULL if none. */
+    char                        **split_children;   /* NULL if none. */
+    int                         n_split_children;
+    struct intf_user_cfg        user_cfg;
+    struct intf_oper_state      op_state;
+    struct intf_pm_info         pm_info;
+    struct intfd_arbiter_state  arbiter;
+
+    /* Statistics, as in struct iface. */
+    unsigned long long int      cfg_n_latency;
+    long long int               cfg_last_latency;
+    long long int               cfg_max_latency;
+    unsigned long long int      cfg_total_latency;
+    unsigned long long int      n_history;
+    struct intfd_history_entry  history[INTFD_HISTORY_LEN];
+    struct intfd_cost           *cost;      /* NULL if never charged. */
+};
+
+/* An interface of a snapshot, by name. */
+struct intfd_snapshot_name {
+    struct hmap_node            node;       /* In intfd_snapshot_index. */
+    size_t                      idx;        /* In the snapshot 'intfs'. */
+};
+
+/* The interfaces of a snapshot by name.  It only depends on the set of
+ * interfaces, so it is shared by every snapshot published until one is
+ * added or deleted. */
+struct intfd_snapshot_index {
+    struct ovs_refcount         ref_cnt;    /* The main thread, snapshots. */
+    struct hmap                 names;
+    struct intfd_snapshot_name  nodes[];
+};
+
+/* The computed state of every interface, as of the end of an iteration of
+ * intfd_run().  A snapshot is never modified once published, so readers
+ * may use it from any thread, for as long as they hold a reference. */
+struct intfd_snapshot {
+    struct ovs_refcount         ref_cnt;
+    unsigned long long int      version;
+    struct intfd_snapshot_index *index;
+
+    /* Statistics of the daemon, as of the publication. */
+    struct intfd_startup_stats  startup_stats;
+    struct intfd_perf_histogram cfg_latency;
+    struct intfd_transition     slowest[INTFD_N_SLOWEST_TRANSITIONS];
+    size_t                      n_slowest;
+    unsigned int                n_failed_transitions;
+
+    size_t                      n_intfs;
+    struct intfd_snapshot_intf  *intfs[];   /* Sorted by name. */
+};
+
+static OVSRCU_TYPE(struct intfd_snapshot *) snapshot;
+static unsigned long long int snapshot_version;
+
+/* Set when an interface changed since the last publication. */
+static bool snapshot_dirty;
+
+/* The interfaces sorted by name, and their index, rebuilt when one is
+ * added or deleted. */
+static struct iface **sorted_ifaces;
+static size_t n_sorted_ifaces;
+static struct intfd_snapshot_index *snapshot_index;
+static bool snapshot_resort = true;
+
+static struct intfd_snapshot_intf *
+intfd_snapshot_intf_create(const struct iface *intf)
+{
+    struct intfd_snapshot_intf *entry = xzalloc(sizeof *entry);
+    int i;
+
+    ovs_refcount_init(&entry->ref_cnt);
+    entry->name = xstrdup(intf->name);
+    if (intf->split_parent) {
+        entry->split_parent = xstrdup(intf->split_parent->name);
+    }
+    if (intf->split_children) {
+        entry->split_children = xcalloc(MAX(intf->n_split_children, 1),
+                                        sizeof *entry->split_children);
+        for (i = 0; i < intf->n_split_children; i++) {
+            if (intf->split_children[i]) {
+                entry->split_children[i] =
+                    xstrdup(intf->split_children[i]->name);
+            }
+        }
+        entry->n_split_children = intf->n_split_children;
+    }
+    entry->user_cfg = intf->user_cfg;
+    entry->op_state = intf->op_state;
+    entry->pm_info = intf->pm_info;
+    entry->arbiter = intf->arbiter;
+
+    entry->cfg_n_latency = intf->cfg_n_latency;
+    entry->cfg_last_latency = intf->cfg_last_latency;
+    entry->cfg_max_latency = intf->cfg_max_latency;
+    entry->cfg_total_latency = intf->cfg_total_latency;
+    entry->n_history = intf->n_history;
+    memcpy(entry->history, intf->history, sizeof entry->history);
+    if (intf->cost) {
+        entry->cost = xmemdup(intf->cost, sizeof *intf->cost);
+    }
+
+    return entry;
+} /* intfd_snapshot_intf_create */
+
+static void
+intfd_snapshot_intf_unref(struct intfd_snapshot_intf *entry)
+{
+    int i;
+
+    if (entry && ovs_refcount_unref(&entry->ref_cnt) == 1) {
+        for (i = 0; i < entry->n_split_children; i++) {
+            free(entry->split_children[i]);
+        }
+        free(entry->split_children);
+        free(entry->split_parent);
+        free(entry->cost);
+        free(entry->name);
+        free(entry);
+    }
+} /* intfd_snapshot_intf_unref */
+
+static void
+intfd_snapshot_index_unref(struct intfd_snapshot_index *index)
+{
+    if (index && ovs_refcount_unref(&index->ref_cnt) == 1) {
+        hmap_destroy(&index->names);
+        free(index);
+    }
+} /* intfd_snapshot_index_unref */
+
+static void
+intfd_snapshot_free(struct intfd_snapshot *snap)
+{
+    size_t i;
+
+    for (i = 0; i < snap->n_slowest; i++) {
+        free(snap->slowest[i].name);
+    }
+    for (i = 0; i < snap->n_intfs; i++) {
+        intfd_snapshot_intf_unref(snap->intfs[i]);
+    }
+    intfd_snapshot_index_unref(snap->index);
+    free(snap);
+} /* intfd_snapshot_free */
+
+/* Returns a reference to the current snapshot, to be released with
+ * intfd_snapshot_unref().  May be called from any thread. */
+struct intfd_snapshot *
+intfd_snapshot_get(void)
+{
+    struct intfd_snapshot *snap;
+
+    /* A snapshot whose last reference is gone is being replaced. */
+    do {
+        snap = ovsrcu_get(struct intfd_snapshot *, &snapshot);
+    } while (!ovs_refcount_try_ref_rcu(&snap->ref_cnt));
+
+    return snap;
+} /* intfd_snapshot_get */
+
 void
-intfd_debug_dump(struct ds *ds, int argc, const char *argv[])
+intfd_snapshot_unref(struct intfd_snapshot *snap)
+{
+    if (snap && ovs_refcount_unref(&snap->ref_cnt) == 1) {
+        ovsrcu_postpone(intfd_snapshot_free, snap);
+    }
+} /* intfd_snapshot_unref */
+
+/* Notes that the state of 'intf' has to be published again. */
+static void
+intfd_snapshot_mark(struct iface *intf)
+{
+    intf->snap_dirty = true;
+    snapshot_dirty = true;
+} /* intfd_snapshot_mark */
+
+static void
+intfd_snapshot_resort(void)
+{
+    const struct shash_node **nodes;
+    struct intfd_snapshot_name *name;
+    size_t i;
+
+    n_sorted_ifaces = shash_count(&all_interfaces);
+    nodes = shash_sort(&all_interfaces);
+    free(sorted_ifaces);
+    sorted_ifaces = xmalloc(MAX(n_sorted_ifaces, 1) * sizeof *sorted_ifaces);
+    intfd_snapshot_index_unref(snapshot_index);
+    snapshot_index = xmalloc(sizeof *snapshot_index
+                             + n_sorted_ifaces * sizeof *name);
+    ovs_refcount_init(&snapshot_index->ref_cnt);
+    hmap_init(&snapshot_index->names);
+    hmap_reserve(&snapshot_index->names, n_sorted_ifaces);
+    for (i = 0; i < n_sorted_ifaces; i++) {
+        sorted_ifaces[i] = nodes[i]->data;
+        name = &snapshot_index->nodes[i];
+        name->idx = i;
+        hmap_insert(&snapshot_index->names, &name->node,
+                    hash_string(nodes[i]->name, 0));
+    }
+    free(nodes);
+    snapshot_resort = false;
+} /* intfd_snapshot_resort */
+
+/* Publishes the state of every interface, if any changed since the last
+ * publication.  Only the interfaces that changed get a new entry, the
+ * others share the one of the previous snapshot. */
+static void
+intfd_snapshot_publish(void)
+{
+    struct intfd_snapshot *snap, *old;
+    struct iface *intf;
+    size_t i;
+
+    if (!snapshot_dirty) {
+        return;
+    }
+    if (snapshot_resort) {
+        intfd_snapshot_resort();
+    }
+
+    snap = xmalloc(sizeof *snap + n_sorted_ifaces * sizeof snap->intfs[0]);
+    ovs_refcount_init(&snap->ref_cnt);
+    snap->version = ++snapshot_version;
+    snap->index = snapshot_index;
+    ovs_refcount_ref(&snapshot_index->ref_cnt);
+    snap->startup_stats = startup_stats;
+    snap->cfg_latency = cfg_latency;
+    for (i = 0; i < n_slowest; i++) {
+        snap->slowest[i] = slowest[i];
+        snap->slowest[i].name = xstrdup(slowest[i].name);
+    }
+    snap->n_slowest = n_slowest;
+    snap->n_failed_transitions = n_failed_transitions;
+    snap->n_intfs = n_sorted_ifaces;
+    for (i = 0; i < n_sorted_ifaces; i++) {
+        intf = sorted_ifaces[i];
+        if (intf->snap_dirty || !intf->snap) {
+            intfd_snapshot_intf_unref(intf->snap);
+            intf->snap = intfd_snapshot_intf_create(intf);
+            intf->snap_dirty = false;
+        }
+        ovs_refcount_ref(&intf->snap->ref_cnt);
+        snap->intfs[i] = intf->snap;
+    }
+
+    old = ovsrcu_get_protected(struct intfd_snapshot *, &snapshot);
+    ovsrcu_set(&snapshot, snap);
+    intfd_snapshot_unref(old);
+    snapshot_dirty = false;
+} /* intfd_snapshot_publish */
+
+/* Returns the index of 'name' in 'snap', or -1. */
+static ssize_t
+intfd_snapshot_find(const struct intfd_snapshot *snap, const char *name)
+{
+    struct intfd_snapshot_name *entry;
+
+    HMAP_FOR_EACH_WITH_HASH (entry, node, hash_string(name, 0),
+                             &snap->index->names) {
+        if (!strcmp(snap->intfs[entry->idx]->name, name)) {
+            return entry->idx;
+        }
+    }
+    return -1;
+} /* intfd_snapshot_find */
+
+enum intfd_dump_split {
+    INTFD_DUMP_SPLIT_ANY,
+    INTFD_DUMP_SPLIT_NONE,          /* Neither parent nor child. */
+    INTFD_DUMP_SPLIT_PARENT,        /* Has split children. */
+    INTFD_DUMP_SPLIT_CHILD          /* Has a split parent. */
+};
+
+/* An ops-intfd/dump.  It reads the snapshot that was current when it was
+ * created, so it neither touches the interfaces nor sees the changes
+ * processed while it is built. */
+struct intfd_dump {
+    bool json;
+    char *reason;                   /* NULL for any. */
+    int connector;                  /* -1 for any. */
+    int admin;                      /* -1 for any. */
+    enum intfd_dump_split split;
+
+    struct intfd_snapshot *snap;
+    size_t first;                   /* Range of 'snap' to dump. */
+    size_t end;
+};
+
+static int
+intfd_dump_parse_connector(const char *name)
 {
-    struct shash_node *sh_node;
-    bool list_all_intf = true;
-    const char *interface_name;
     int i;
 
-    if (argc > 1) {
-        list_all_intf = false;
-        interface_name = argv[1];
+    for (i = 0; i < ARRAY_SIZE(interface_pm_info_connector_strings); i++) {
+        if (!strcmp(name, interface_pm_info_connector_strings[i])) {
+            return i;
+        }
     }
+    return -1;
+} /* intfd_dump_parse_connector */
 
-    if (list_all_intf) {
-        ds_put_cstr(ds, "================ Interfaces ================\n");
+/* Creates a dump of the interfaces matching the filters in 'argv':
+ *
+ *   --json                         JSON instead of text output.
+ *   reason=REASON                  op_state_reason, e.g. admin_down.
+ *   connector=CONNECTOR            pm_info connector, e.g. absent.
+ *   split=none|parent|child        Position in a lane split.
+ *   admin=up|down                  User configured admin state.
+ *   INTERFACE                      Only this interface.
+ *
+ * Returns NULL and sets '*errorp' to a malloc()'d error message if an
+ * argument is invalid. */
+struct intfd_dump *
+intfd_dump_create(int argc, const char *argv[], char **errorp)
+{
+    struct intfd_dump *dump = xzalloc(sizeof *dump);
+    const char *interface_name = NULL;
+    const char *value;
+    ssize_t idx;
+    int i;
+
+    dump->connector = -1;
+    dump->admin = -1;
+
+    for (i = 0; i < argc; i++) {
+        value = strchr(argv[i], '=');
+        if (!strcmp(argv[i], "--json")) {
+            dump->json = true;
+        } else if (!value) {
+            interface_name = argv[i];
+        } else if (!strncmp(argv[i], "reason=", value - argv[i] + 1)) {
+            free(dump->reason);
+            dump->reason = xstrdup(value + 1);
+        } else if (!strncmp(argv[i], "connector=", value - argv[i] + 1)) {
+            dump->connector = intfd_dump_parse_connector(value + 1);
+            if (dump->connector < 0) {
+                *errorp = xasprintf("%s: unknown connector", value + 1);
+                goto error;
+            }
+        } else if (!strcmp(argv[i], "split=none")) {
+            dump->split = INTFD_DUMP_SPLIT_NONE;
+        } else if (!strcmp(argv[i], "split=parent")) {
+            dump->split = INTFD_DUMP_SPLIT_PARENT;
+        } else if (!strcmp(argv[i], "split=child")) {
+            dump->split = INTFD_DUMP_SPLIT_CHILD;
+        } else if (!strcmp(argv[i], "admin=up")) {
+            dump->admin = INTERFACE_USER_CONFIG_ADMIN_UP;
+        } else if (!strcmp(argv[i], "admin=down")) {
+            dump->admin = INTERFACE_USER_CONFIG_ADMIN_DOWN;
+        } else {
+            *errorp = xasprintf("%s: unknown filter", argv[i]);
+            goto error;
+        }
+    }
+
+    dump->snap = intfd_snapshot_get();
+    if (interface_name) {
+        idx = intfd_snapshot_find(dump->snap, interface_name);
+        if (idx < 0) {
+            *errorp = xasprintf("%s: no such interface", interface_name);
+            goto error;
+        }
+        dump->first = idx;
+        dump->end = idx + 1;
     } else {
-        ds_put_format(ds, "================ Interface %s ================\n",
-            interface_name);
+        dump->end = dump->snap->n_intfs;
     }
 
-    SHASH_FOR_EACH(sh_node, &all_interfaces) {
-        struct iface *intf = sh_node->data;
-        if (list_all_intf
-            || (!strcmp(interface_name, sh_node->name))) {
-
-            ds_put_format(ds, "Interface %s:\n", intf->name);
-            ds_put_format(ds, "    admin              : %d\n",
-                          intf->user_cfg.admin_state);
-            ds_put_format(ds, "    hw_enable          : %d\n",
-                          intf->op_state.enabled);
-            ds_put_format(ds, "    op_state_reason    : %s\n",
-                          intfd_get_error_str(intf->op_state.reason));
-            ds_put_format(ds, "    cfg_autoneg        : %s\n",
-                          iface_config_autoneg_strings[intf->user_cfg.autoneg]);
-            ds_put_format(ds, "    op_autoneg_state   : %d\n",
-                          intf->op_state.autoneg_state);
-            ds_put_format(ds, "    cfg_speeds         : ");
-            if (intf->user_cfg.n_speeds > 0) {
-                ds_put_format(ds, "%d", intf->user_cfg.speeds[0]);
-                for (i = 1; i < intf->user_cfg.n_speeds; i++) {
-                    ds_put_format(ds, ", %d", intf->user_cfg.speeds[i]);
-                }
-            } else {
-                ds_put_format(ds, "unset");
-            }
-            ds_put_format(ds, "\n");
+    return dump;
 
-            ds_put_format(ds, "    op_speeds          : ");
-            if (intf->op_state.n_speeds > 0) {
-                ds_put_format(ds, "%d", intf->op_state.speeds[0]);
-                for (i = 1; i < intf->op_state.n_speeds; i++) {
-                    ds_put_format(ds, ", %d", intf->op_state.speeds[i]);
-                }
-            } else {
-                ds_put_format(ds, "unset");
-            }
-            ds_put_format(ds, "\n");
-
-            ds_put_format(ds, "    cfg_mtu            : %d\n",
-                          intf->user_cfg.mtu);
-            ds_put_format(ds, "    cfg_pause          : %d\n",
-                          intf->user_cfg.pause);
-            ds_put_format(ds, "    cfg_duplex         : %d\n",
-                          intf->user_cfg.duplex);
-            ds_put_format(ds, "    op_connector       : %s\n",
-                          interface_pm_info_connector_strings[intf->pm_info.connector]);
-            ds_put_format(ds, "    hw_interface_type  : %s\n",
-                          intfd_get_intf_type_str(intf->pm_info.intf_type));
-            ds_put_format(ds, "    lane_split         : %s\n",
-                          intfd_get_lane_split_str(intf->user_cfg.lane_split));
-            ds_put_format(ds, "    split_parent       : %s\n",
-                          intf->split_parent ?
-                          intf->split_parent->name : "none");
-            if (!intf->split_children) {
-                ds_put_format(ds, "    split_children     : none\n");
-            } else {
-                for (i = 0; i < intf->n_split_children; i++) {
-                    ds_put_format(ds, "    split_children[%d]  : %s\n", i,
-                                  intf->split_children[i] ?
-                                  intf->split_children[i]->name : "not found");
-                }
+error:
+    intfd_dump_destroy(dump);
+    return NULL;
+} /* intfd_dump_create */
+
+void
+intfd_dump_destroy(struct intfd_dump *dump)
+{
+    if (dump) {
+        intfd_snapshot_unref(dump->snap);
+        free(dump->reason);
+        free(dump);
+    }
+} /* intfd_dump_destroy */
+
+static bool
+intfd_dump_match(const struct intfd_dump *dump,
+                 const struct intfd_snapshot_intf *intf)
+{
+    if (dump->reason
+        && strcmp(dump->reason, intfd_get_error_str(intf->op_state.reason))) {
+        return false;
+    }
+    if (dump->connector >= 0 && dump->connector != intf->pm_info.connector) {
+        return false;
+    }
+    if (dump->admin >= 0 && dump->admin != intf->user_cfg.admin_state) {
+        return false;
+    }
+
+    switch (dump->split) {
+    case INTFD_DUMP_SPLIT_ANY:
+        return true;
+    case INTFD_DUMP_SPLIT_NONE:
+        return !intf->split_parent && !intf->split_children;
+    case INTFD_DUMP_SPLIT_PARENT:
+        return intf->split_children != NULL;
+    case INTFD_DUMP_SPLIT_CHILD:
+        return intf->split_parent != NULL;
+    }
+    return false;
+} /* intfd_dump_match */
+
+static void
+intfd_dump_speeds(struct ds *ds, const uint32_t *speeds, int n_speeds)
+{
+    int i;
+
+    if (n_speeds > 0) {
+        ds_put_format(ds, "%d", speeds[0]);
+        for (i = 1; i < n_speeds; i++) {
+            ds_put_format(ds, ", %d", speeds[i]);
+        }
+    } else {
+        ds_put_format(ds, "unset");
+    }
+    ds_put_format(ds, "\n");
+} /* intfd_dump_speeds */
+
+static void
+intfd_dump_intf_text(struct ds *ds, const struct intfd_snapshot_intf *intf)
+{
+    int i;
+
+    ds_put_format(ds, "Interface %s:\n", intf->name);
+    ds_put_format(ds, "    admin              : %d\n",
+                  intf->user_cfg.admin_state);
+    ds_put_format(ds, "    hw_enable          : %d\n",
+                  intf->op_state.enabled);
+    ds_put_format(ds, "    op_state_reason    : %s\n",
+                  intfd_get_error_str(intf->op_state.reason));
+    ds_put_format(ds, "    cfg_autoneg        : %s\n",
+                  iface_config_autoneg_strings[intf->user_cfg.autoneg]);
+    ds_put_format(ds, "    op_autoneg_state   : %d\n",
+                  intf->op_state.autoneg_state);
+    ds_put_format(ds, "    cfg_speeds         : ");
+    intfd_dump_speeds(ds, intf->user_cfg.speeds, intf->user_cfg.n_speeds);
+    ds_put_format(ds, "    op_speeds          : ");
+    intfd_dump_speeds(ds, intf->op_state.speeds, intf->op_state.n_speeds);
+    ds_put_format(ds, "    cfg_mtu            : %d\n",
+                  intf->user_cfg.mtu);
+    ds_put_format(ds, "    cfg_pause          : %d\n",
+                  intf->user_cfg.pause);
+    ds_put_format(ds, "    cfg_duplex         : %d\n",
+                  intf->user_cfg.duplex);
+    ds_put_format(ds, "    op_connector       : %s\n",
+                  interface_pm_info_connector_strings[intf->pm_info.connector]);
+    ds_put_format(ds, "    hw_interface_type  : %s\n",
+                  intfd_get_intf_type_str(intf->pm_info.intf_type));
+    ds_put_format(ds, "    lane_split         : %s\n",
+                  intfd_get_lane_split_str(intf->user_cfg.lane_split));
+    ds_put_format(ds, "    split_parent       : %s\n",
+                  intf->split_parent ? intf->split_parent : "none");
+    if (!intf->split_children) {
+        ds_put_format(ds, "    split_children     : none\n");
+    } else {
+        for (i = 0; i < intf->n_split_children; i++) {
+            ds_put_format(ds, "    split_children[%d]  : %s\n", i,
+                          intf->split_children[i] ?
+                          intf->split_children[i] : "not found");
+        }
+    }
+    intfd_arbiter_dump_holds(ds, &intf->arbiter, time_msec());
+} /* intfd_dump_intf_text */
+
+static struct json *
+intfd_dump_speeds_json(const uint32_t *speeds, int n_speeds)
+{
+    struct json *array = json_array_create_empty();
+    int i;
+
+    for (i = 0; i < n_speeds; i++) {
+        json_array_add(array, json_integer_create(speeds[i]));
+    }
+    return array;
+} /* intfd_dump_speeds_json */
+
+static void
+intfd_dump_intf_json(struct ds *ds, const struct intfd_snapshot_intf *intf)
+{
+    struct json *json = json_object_create();
+    struct json *children, *holds;
+    int i;
+
+    json_object_put_string(json, "name", intf->name);
+    json_object_put(json, "admin",
+                    json_integer_create(intf->user_cfg.admin_state));
+    json_object_put(json, "hw_enable",
+                    json_boolean_create(intf->op_state.enabled));
+    json_object_put_string(json, "op_state_reason",
+                           intfd_get_error_str(intf->op_state.reason));
+    json_object_put_string(json, "cfg_autoneg",
+                           iface_config_autoneg_strings[intf->user_cfg.autoneg]);
+    json_object_put(json, "op_autoneg_state",
+                    json_integer_create(intf->op_state.autoneg_state));
+    json_object_put(json, "cfg_speeds",
+                    intfd_dump_speeds_json(intf->user_cfg.speeds,
+                                           intf->user_cfg.n_speeds));
+    json_object_put(json, "op_speeds",
+                    intfd_dump_speeds_json(intf->op_state.speeds,
+                                           intf->op_state.n_speeds));
+    json_object_put(json, "cfg_mtu", json_integer_create(intf->user_cfg.mtu));
+    json_object_put(json, "cfg_pause",
+                    json_integer_create(intf->user_cfg.pause));
+    json_object_put(json, "cfg_duplex",
+                    json_integer_create(intf->user_cfg.duplex));
+    json_object_put_string(json, "op_connector",
+            interface_pm_info_connector_strings[intf->pm_info.connector]);
+    json_object_put_string(json, "hw_interface_type",
+            intfd_get_intf_type_str(intf->pm_info.intf_type));
+    json_object_put_string(json, "lane_split",
+            intfd_get_lane_split_str(intf->user_cfg.lane_split));
+    if (intf->split_parent) {
+        json_object_put_string(json, "split_parent", intf->split_parent);
+    }
+    if (intf->split_children) {
+        children = json_array_create_empty();
+        for (i = 0; i < intf->n_split_children; i++) {
+            json_array_add(children, intf->split_children[i]
+                           ? json_string_create(intf->split_children[i])
+                           : json_null_create());
+        }
+        json_object_put(json, "split_children", children);
+    }
+    holds = intfd_arbiter_dump_holds_json(&intf->arbiter, time_msec());
+    if (holds) {
+        json_object_put(json, "holds", holds);
+    }
+
+    json_to_ds(json, 0, ds);
+    json_destroy(json);
+} /* intfd_dump_intf_json */
+
+/* Appends the interfaces of 'dump' to 'ds'. */
+void
+intfd_dump_run(const struct intfd_dump *dump, struct ds *ds)
+{
+    const struct intfd_snapshot_intf *intf;
+    size_t n_matched = 0;
+    size_t i;
+
+    if (dump->json) {
+        ds_put_char(ds, '[');
+    } else {
+        ds_put_cstr(ds, "================ Interfaces ================\n");
+        ds_put_format(ds, "Snapshot version       : %llu\n",
+                      dump->snap->version);
+    }
+
+    for (i = dump->first; i < dump->end; i++) {
+        intf = dump->snap->intfs[i];
+        if (!intfd_dump_match(dump, intf)) {
+            continue;
+        }
+        if (dump->json) {
+            if (n_matched) {
+                ds_put_char(ds, ',');
             }
+            intfd_dump_intf_json(ds, intf);
+        } else {
+            intfd_dump_intf_text(ds, intf);
         }
+        n_matched++;
     }
 
-} /* intfd_debug_dump */
+    if (dump->json) {
+        ds_put_cstr(ds, "]\n");
+    }
+} /* intfd_dump_run */
 
 static uint64_t
 get_connector_flags(enum ovsrec_interface_pm_info_connector_e connector)
@@ -422,6 +1116,10 @@ intfd_ovsdb_init(const char *db_path)
     ovsdb_idl_add_column(idl, &ovsrec_port_col_admin);
     ovsdb_idl_add_column(idl, &ovsrec_port_col_interfaces);
     ovsdb_idl_add_column(idl, &ovsrec_port_col_name);
+
+    /* Readers always find a snapshot, empty until the first iteration. */
+    snapshot_dirty = true;
+    intfd_snapshot_publish();
 } /* intfd_ovsdb_init */
 
 void
@@ -432,6 +1130,18 @@ intfd_ovsdb_exit(void)
     SHASH_FOR_EACH_SAFE(sh_node, sh_next, &all_interfaces) {
         del_old_interface(sh_node);
     }
+    intfd_snapshot_unref(ovsrcu_get_protected(struct intfd_snapshot *,
+                                              &snapshot));
+    ovsrcu_set(&snapshot, NULL);
+    intfd_snapshot_index_unref(snapshot_index);
+    free(sorted_ifaces);
+    free(pending_writes);
+    free(pending_arbiter);
+    free(txn_inflight);
+    free(txn_arbiter);
+    while (n_slowest) {
+        free(slowest[--n_slowest].name);
+    }
     ovsdb_idl_destroy(idl);
 } /* intfd_ovsdb_exit */
 
@@ -448,6 +1158,14 @@ is_a_number(const char *nbr)
 
 } /* is_a_number */
 
+/* Compares two possibly NULL strings. */
+static bool
+intfd_str_is_equal(const char *a, const char *b)
+{
+    return (a == NULL || b == NULL) ? (a == b) : !strcmp(a, b);
+
+} /* intfd_str_is_equal */
+
 static int
 parse_speeds(const char *speeds_str, uint32_t *speeds)
 {
@@ -518,25 +1236,45 @@ get_matching_interface_row(const char *name)
     return NULL;
 }
 
+/* Returns the admin state that 'port_row', if nonnull, gives its member
+ * interfaces. */
+static enum ovsrec_port_config_admin_e
+port_row_parse_admin(const struct ovsrec_port *port_row)
+{
+    if (port_row
+        && (!port_row->admin || !strcmp(port_row->admin, "up"))) {
+        return PORT_ADMIN_CONFIG_UP;
+    }
+    return PORT_ADMIN_CONFIG_DOWN;
+} /* port_row_parse_admin */
+
 static int
 port_parse_admin(enum ovsrec_port_config_admin_e  *port_admin,
                  const struct ovsrec_interface *ifrow)
 {
     const struct ovsrec_port *port_row = NULL;
-    *port_admin = PORT_ADMIN_CONFIG_DOWN;
-    int rc = 0;
 
     port_row = get_matching_port_row(ifrow->name);
-    if(port_row) {
-        if ((port_row->admin == NULL) || (strcmp(port_row->admin, "up") == 0)) {
-            *port_admin = PORT_ADMIN_CONFIG_UP;
-        } else {
-            *port_admin = PORT_ADMIN_CONFIG_DOWN;
+    *port_admin = port_row_parse_admin(port_row);
+    return port_row != NULL;
+}
+
+/* Maps, in the empty 'port_map', the name of every interface that is a
+ * member of a port to the port row, in a single walk of the Port table,
+ * where get_matching_port_row() walks it for each interface. */
+static void
+intfd_port_map_build(struct shash *port_map)
+{
+    const struct ovsrec_port *port_row;
+    size_t i;
+
+    OVSREC_PORT_FOR_EACH(port_row, idl) {
+        for (i = 0; i < port_row->n_interfaces; i++) {
+            shash_add_once(port_map, port_row->interfaces[i]->name,
+                           port_row);
         }
-        rc++;
     }
-    return rc;
-}
+} /* intfd_port_map_build */
 
 static enum ovsrec_interface_user_config_admin_e
 intf_parse_admin(const struct ovsrec_interface *intf_row) {
@@ -943,6 +1681,8 @@ intfd_process_parent_child(struct iface *intf,
     } else if (ifrow->split_children) {
         struct iface *if_child_p;
 
+        /* The row may be re-sent after a reconnect; drop the old array. */
+        free(intf->split_children);
         intf->split_children = xcalloc(ifrow->n_split_children,
                                        sizeof(struct iface *));
         for (i = 0; i < ifrow->n_split_children; i++) {
@@ -1075,8 +1815,10 @@ add_new_interface(const struct ovsrec_interface *ifrow)
 
     /* Allocate structure to save state information for this interface. */
     new_intf = xzalloc(sizeof *new_intf);
+    COVERAGE_INC(intfd_intf_added);
 
     shash_add(&all_interfaces, ifrow->name, new_intf);
+    snapshot_resort = true;
 
     new_intf->name = xstrdup(ifrow->name);
 
@@ -1097,62 +1839,273 @@ add_new_interface(const struct ovsrec_interface *ifrow)
 
 } /* add_new_interface */
 
-static void
-del_old_interface(struct shash_node *sh_node)
+static struct iface *
+intfd_bulk_find(const struct hmap *row_map,
+                const struct ovsrec_interface *row)
 {
-    if (sh_node) {
-        struct iface *intf = sh_node->data;
-        free(intf->name);
-        free(intf->type);
-        if (intf->split_children) {
-            free(intf->split_children);
+    struct iface_row_ref *ref;
+
+    HMAP_FOR_EACH_WITH_HASH (ref, node, hash_pointer(row, 0), row_map) {
+        if (ref->row == row) {
+            return ref->intf;
         }
-        free(intf);
-        shash_delete(&all_interfaces, sh_node);
     }
-} /* del_old_interface */
+    return NULL;
 
+} /* intfd_bulk_find */
+
+/* Populates 'all_interfaces' from an empty state with every row of the
+ * Interface table.  Unlike add_new_interface() followed by
+ * intfd_process_parent_child() per row, the hash table is sized once,
+ * the interfaces are allocated in one block, the port admin state is
+ * taken from intfd_port_map_build() and the split relationships are
+ * resolved through row pointers in one pass. */
 static void
-del_old_port(struct shash_node *sh_node)
+intfd_bulk_load(void)
 {
-    int j;
-    const struct ovsrec_interface *intf_row = NULL;
-    struct smap hw_cfg_smap;
+    const struct ovsrec_interface *ifrow;
+    struct iface_row_ref *refs;
+    struct iface_slab *slab;
+    struct iface *intf;
+    struct shash port_map;
+    struct hmap row_map;
+    size_t n_rows = 0, n = 0, i, j;
 
-    if (sh_node) {
-        struct port_info *port_data = sh_node->data;
-        for(j = 0; j < port_data->n_interfaces; j++) {
-            smap_init(&hw_cfg_smap);
-            intf_row = port_data->interface[j];
-            /* logical interface details will not be there in
-               interface table since it has been deleted */
-            struct ovsrec_interface *intf = get_matching_interface_row(sh_node->name);
-            /* skip this for virtual interfaces */
-            if(intf){
-                /* Making sure not to reset a physical interface associated
-                   with another port */
-                if (!get_matching_port_row(intf_row->name))
-                {
-                    VLOG_DBG("Port delete : reset interface %s\n", intf_row->name);
-                    smap_add(&hw_cfg_smap, INTERFACE_HW_INTF_CONFIG_MAP_ENABLE,
-                             INTERFACE_HW_INTF_CONFIG_MAP_ENABLE_FALSE);
-                    ovsrec_interface_set_hw_intf_config(intf_row, &hw_cfg_smap);
+    OVSREC_INTERFACE_FOR_EACH(ifrow, idl) {
+        n_rows++;
+    }
+    if (!n_rows) {
+        return;
+    }
+
+    VLOG_DBG("Bulk-loading %"PRIuSIZE" interfaces", n_rows);
+
+    slab = xzalloc(sizeof *slab + n_rows * sizeof slab->ifaces[0]);
+    refs = xmalloc(n_rows * sizeof *refs);
+    hmap_init(&row_map);
+    hmap_reserve(&row_map, n_rows);
+    hmap_reserve(&all_interfaces.map, n_rows);
+    shash_init(&port_map);
+    intfd_port_map_build(&port_map);
+
+    /* Parse every row into the next slot of the slab. */
+    OVSREC_INTERFACE_FOR_EACH(ifrow, idl) {
+        intf = &slab->ifaces[n];
+        if (!shash_add_once(&all_interfaces, ifrow->name, intf)) {
+            VLOG_WARN("Interface %s specified twice", ifrow->name);
+            continue;
+        }
+
+        COVERAGE_INC(intfd_intf_added);
+        intf->slab = slab;
+        intf->name = xstrdup(ifrow->name);
+        intf->type = xstrdup(ifrow->type);
+        intf->port_admin = port_row_parse_admin(shash_find_data(&port_map,
+                                                                ifrow->name));
+        intfd_parse_hw_info(&(intf->hw_info), &(ifrow->hw_intf_info));
+        intfd_parse_user_cfg(&(intf->user_cfg), &(ifrow->user_config),
+                             &(ifrow->hw_intf_info));
+        intfd_parse_pm_info(&(intf->hw_info), &(intf->pm_info),
+                            &(ifrow->pm_info));
+
+        refs[n].row = ifrow;
+        refs[n].intf = intf;
+        hmap_insert(&row_map, &refs[n].node, hash_pointer(ifrow, 0));
+        n++;
+    }
+    slab->n_live = n;
+    shash_destroy(&port_map);
+
+    /* Split parents and children. */
+    for (i = 0; i < n; i++) {
+        ifrow = refs[i].row;
+        intf = refs[i].intf;
+
+        if (ifrow->split_parent) {
+            intf->split_parent = intfd_bulk_find(&row_map, ifrow->split_parent);
+            if (!intf->split_parent) {
+                VLOG_WARN("Could not find parent ifrow->name %s in "
+                          "all_interfaces!", ifrow->split_parent->name);
+                continue;
+            }
+
+            /* Children ports take PM info from their parent. */
+            intfd_parse_split_pm_info(&(intf->pm_info),
+                                      &(ifrow->split_parent->pm_info));
+
+        } else if (ifrow->split_children) {
+            intf->split_children = xcalloc(ifrow->n_split_children,
+                                           sizeof(struct iface *));
+            for (j = 0; j < ifrow->n_split_children; j++) {
+                intf->split_children[j] =
+                    intfd_bulk_find(&row_map, ifrow->split_children[j]);
+                if (!intf->split_children[j]) {
+                    VLOG_WARN("Could not find child ifrow->name %s in "
+                              "all_interfaces!", ifrow->split_children[j]->name);
                 }
             }
-            smap_destroy(&hw_cfg_smap);
+            intf->n_split_children = ifrow->n_split_children;
         }
-        free(port_data->name);
-        free(port_data->interface);
-        free(port_data);
-        shash_delete(&all_ports, sh_node);
     }
-} /* del_old_port */
 
-/* FUNCTION: calc_intf_op_state_n_reason()
- *
- * This function determines an interface's operational state & reasons:
- *
- *    - op state:        Interface "hw_intf_config:enable"
+    hmap_destroy(&row_map);
+    free(refs);
+    snapshot_resort = true;
+
+} /* intfd_bulk_load */
+
+/* Re-read all the inputs of an already known interface from its row.
+ * Used when the row is re-sent after an OVSDB reconnect, since any of
+ * them may have changed while intfd was disconnected.  'port_map' is
+ * built by intfd_port_map_build(). */
+static void
+intfd_refresh_intf(struct iface *intf, const struct ovsrec_interface *ifrow,
+                   const struct shash *port_map)
+{
+    intfd_parse_hw_info(&(intf->hw_info), &(ifrow->hw_intf_info));
+    intfd_parse_user_cfg(&(intf->user_cfg), &(ifrow->user_config),
+                         &(ifrow->hw_intf_info));
+
+    if (!STR_EQ(intf->type, ifrow->type)) {
+        free(intf->type);
+        intf->type = xstrdup(ifrow->type);
+    }
+
+    /* Split children take their PM info from the parent, which is
+     * handled by intfd_process_parent_child(). */
+    if (!ifrow->split_parent) {
+        intfd_parse_pm_info(&(intf->hw_info), &(intf->pm_info), &(ifrow->pm_info));
+    }
+    intf->port_admin = port_row_parse_admin(shash_find_data(port_map,
+                                                            ifrow->name));
+
+} /* intfd_refresh_intf */
+
+/* Re-point a cached port at the rows of the current IDL session.  Row
+ * pointers from the previous session are stale after a reconnect. */
+static void
+intfd_refresh_port(struct port_info *port_data,
+                   const struct ovsrec_port *port_row)
+{
+    int i;
+
+    free(port_data->interface);
+    port_data->interface = xmalloc(port_row->n_interfaces *
+                                   sizeof(struct ovsrec_interface *));
+    port_data->n_interfaces = port_row->n_interfaces;
+    for (i = 0; i < port_row->n_interfaces; i++) {
+        port_data->interface[i] = port_row->interfaces[i];
+    }
+
+} /* intfd_refresh_port */
+
+static void
+intfd_free_port(struct shash_node *sh_node)
+{
+    struct port_info *port_data = sh_node->data;
+
+    free(port_data->name);
+    free(port_data->interface);
+    free(port_data);
+    shash_delete(&all_ports, sh_node);
+} /* intfd_free_port */
+
+/* Brings the cached ports in line with the Port table after a reconnect.
+ * Ports that still exist are re-pointed at the rows of the new session.
+ * Ports deleted while disconnected are dropped without touching their
+ * former members: their row pointers are stale, and every interface is
+ * re-evaluated against the current Port table by the same resync. */
+static void
+intfd_resync_ports(void)
+{
+    const struct ovsrec_port *port_row;
+    struct shash_node *sh_node, *sh_next;
+    struct shash sh_idl_ports;
+
+    shash_init(&sh_idl_ports);
+    OVSREC_PORT_FOR_EACH(port_row, idl) {
+        shash_add_once(&sh_idl_ports, port_row->name, port_row);
+    }
+
+    SHASH_FOR_EACH_SAFE(sh_node, sh_next, &all_ports) {
+        port_row = shash_find_data(&sh_idl_ports, sh_node->name);
+        if (port_row) {
+            intfd_refresh_port(sh_node->data, port_row);
+        } else {
+            VLOG_DBG("Dropping port %s deleted while disconnected",
+                     sh_node->name);
+            intfd_free_port(sh_node);
+        }
+    }
+
+    shash_destroy(&sh_idl_ports);
+} /* intfd_resync_ports */
+
+static void
+del_old_interface(struct shash_node *sh_node)
+{
+    if (sh_node) {
+        struct iface *intf = sh_node->data;
+        COVERAGE_INC(intfd_intf_deleted);
+        free(intf->name);
+        free(intf->type);
+        if (intf->split_children) {
+            free(intf->split_children);
+        }
+        if (intf->write_pending) {
+            pending_writes[intf->pending_idx] = NULL;
+        }
+        if (intf->arbiter_pending) {
+            pending_arbiter[intf->arbiter_idx] = NULL;
+        }
+        intfd_snapshot_intf_unref(intf->snap);
+        free(intf->cost);
+        snapshot_resort = true;
+        snapshot_dirty = true;
+        if (!intf->slab) {
+            free(intf);
+        } else if (!--intf->slab->n_live) {
+            free(intf->slab);
+        }
+        shash_delete(&all_interfaces, sh_node);
+    }
+} /* del_old_interface */
+
+static void
+del_old_port(struct shash_node *sh_node)
+{
+    int j;
+    const struct ovsrec_interface *intf_row = NULL;
+    struct iface *member;
+
+    if (sh_node) {
+        struct port_info *port_data = sh_node->data;
+        for(j = 0; j < port_data->n_interfaces; j++) {
+            intf_row = port_data->interface[j];
+            /* logical interface details will not be there in
+               interface table since it has been deleted */
+            struct ovsrec_interface *intf = get_matching_interface_row(sh_node->name);
+            /* skip this for virtual interfaces */
+            if(intf){
+                /* Making sure not to reset a physical interface associated
+                   with another port */
+                member = shash_find_data(&all_interfaces, intf_row->name);
+                if (member && !get_matching_port_row(intf_row->name))
+                {
+                    VLOG_DBG("Port delete : reset interface %s\n", intf_row->name);
+                    intfd_queue_reset(member, intf_row);
+                }
+            }
+        }
+        intfd_free_port(sh_node);
+    }
+} /* del_old_port */
+
+/* FUNCTION: calc_intf_op_state_n_reason()
+ *
+ * This function determines an interface's operational state & reasons:
+ *
+ *    - op state:        Interface "hw_intf_config:enable"
  *    - op state reason: Interface "error"
  *
  * Following is a complete summary of the different operational states
@@ -1488,10 +2441,16 @@ validate_n_set_interface_capability(struct iface *intf)
 
 } /* validate_n_set_interface_capability */
 
-void
+/* Writes the computed H/W config and error of 'intf' to its row.  Columns
+ * whose current value already matches are left alone, so re-evaluating an
+ * unchanged interface (e.g. after a reconnect) emits no writes.
+ *
+ * Returns true if any column was written. */
+bool
 set_intf_hw_config_in_db(const struct ovsrec_interface *ifrow, struct iface *intf)
 {
     const char *tmp_str = NULL;
+    bool written = false;
 
     struct smap smap = SMAP_INITIALIZER(&smap);
 
@@ -1500,7 +2459,10 @@ set_intf_hw_config_in_db(const struct ovsrec_interface *ifrow, struct iface *int
     if (intf->op_state.enabled != true) {
         tmp_str = intfd_get_error_str(intf->op_state.reason);
     }
-    ovsrec_interface_set_error(ifrow, tmp_str);
+    if (!intfd_str_is_equal(tmp_str, ifrow->error)) {
+        ovsrec_interface_set_error(ifrow, tmp_str);
+        written = true;
+    }
 
     /* We want to build up a new hw_intf_config map. */
 
@@ -1571,10 +2533,38 @@ set_intf_hw_config_in_db(const struct ovsrec_interface *ifrow, struct iface *int
                   intfd_get_intf_type_str(intf->pm_info.intf_type));
     }
 
-    ovsrec_interface_set_hw_intf_config(ifrow, &smap);
+    if (!smap_equal(&smap, &ifrow->hw_intf_config)) {
+        ovsrec_interface_set_hw_intf_config(ifrow, &smap);
+        written = true;
+    }
+    smap_destroy(&smap);
+
+    return written;
 
 } /* set_intf_hw_config_in_db */
 
+/* Writes a H/W config of only "enable=false" to 'ifrow', unless it already
+ * is, for an interface queued by intfd_queue_reset().
+ *
+ * Returns true if the column was written. */
+static bool
+intfd_reset_hw_config_in_db(const struct ovsrec_interface *ifrow)
+{
+    struct smap smap = SMAP_INITIALIZER(&smap);
+    bool written = false;
+
+    smap_add(&smap, INTERFACE_HW_INTF_CONFIG_MAP_ENABLE,
+             INTERFACE_HW_INTF_CONFIG_MAP_ENABLE_FALSE);
+    if (!smap_equal(&smap, &ifrow->hw_intf_config)) {
+        ovsrec_interface_set_hw_intf_config(ifrow, &smap);
+        written = true;
+    }
+    smap_destroy(&smap);
+
+    return written;
+
+} /* intfd_reset_hw_config_in_db */
+
 static void
 set_op_state_mtu(struct iface *intf)
 {
@@ -1592,10 +2582,102 @@ set_op_state_mtu(struct iface *intf)
     }
 } /* set_op_state_mtu */
 
-void
-set_interface_config(const struct ovsrec_interface *ifrow, struct iface *intf)
+/* Queues 'intf' to have its state evaluated by intfd_evaluate_pending()
+ * and written to 'ifrow' by intfd_flush_writes().  An interface queued
+ * again moves to the end, so writes keep the order of the last change,
+ * e.g. a split parent before its children. */
+static void
+intfd_queue_write(struct iface *intf, const struct ovsrec_interface *ifrow)
 {
-    VLOG_DBG("Received new config for interface %s", ifrow->name);
+    if (intf->write_pending) {
+        pending_writes[intf->pending_idx] = NULL;
+    }
+    if (n_pending_writes >= allocated_pending_writes) {
+        pending_writes = x2nrealloc(pending_writes, &allocated_pending_writes,
+                                    sizeof *pending_writes);
+    }
+
+    intf->row_uuid = ifrow->header_.uuid;
+    intf->pending_idx = n_pending_writes;
+    intf->eval_pending = true;
+    intf->write_pending = true;
+    intf->reset_pending = false;
+    pending_writes[n_pending_writes++] = intf;
+
+} /* intfd_queue_write */
+
+/* Queues 'intf', which left its port, to have its H/W config reset to
+ * disabled by intfd_flush_writes() instead of written from its evaluated
+ * state.  The reset is dropped if 'intf' is queued again afterwards. */
+static void
+intfd_queue_reset(struct iface *intf, const struct ovsrec_interface *ifrow)
+{
+    intfd_queue_write(intf, ifrow);
+    intf->reset_pending = true;
+} /* intfd_queue_reset */
+
+/* Returns the number of interfaces queued by intfd_queue_write(). */
+static size_t
+intfd_count_pending_writes(void)
+{
+    size_t n = 0;
+    size_t i;
+
+    for (i = 0; i < n_pending_writes; i++) {
+        if (pending_writes[i]) {
+            n++;
+        }
+    }
+    return n;
+} /* intfd_count_pending_writes */
+
+/* Queues 'intf' for intfd_arbiter_run(), which re-evaluates its forwarding
+ * state if any of the arbiter inputs of 'ifrow' moved. */
+static void
+intfd_queue_arbiter(struct iface *intf, const struct ovsrec_interface *ifrow)
+{
+    intf->row_uuid = ifrow->header_.uuid;
+    intfd_snapshot_mark(intf);
+    if (intf->arbiter_pending) {
+        return;
+    }
+    if (n_pending_arbiter >= allocated_pending_arbiter) {
+        pending_arbiter = x2nrealloc(pending_arbiter,
+                                     &allocated_pending_arbiter,
+                                     sizeof *pending_arbiter);
+    }
+
+    intf->arbiter_idx = n_pending_arbiter;
+    intf->arbiter_pending = true;
+    pending_arbiter[n_pending_arbiter++] = intf;
+
+} /* intfd_queue_arbiter */
+
+/* Appends the change of the op state of 'intf' from 'old_reason' to the
+ * ring of 'intf', overwriting the oldest entry once it is full. */
+static void
+intfd_history_record(struct iface *intf,
+                     enum ovsrec_interface_error_e old_reason)
+{
+    struct intfd_history_entry *entry;
+
+    entry = &intf->history[intf->n_history++ % INTFD_HISTORY_LEN];
+    entry->when = intfd_perf_start();
+    entry->old_reason = old_reason;
+    entry->new_reason = intf->op_state.reason;
+    entry->triggers = intf->eval_triggers;
+} /* intfd_history_record */
+
+/* Computes the operational state of 'intf' from its parsed inputs.
+ *
+ * Only reads the inputs of 'intf' (and the lane split of its parent) and
+ * only writes 'intf->op_state', so different interfaces can be evaluated
+ * concurrently. */
+static void
+intfd_evaluate_intf(struct iface *intf)
+{
+    enum ovsrec_interface_error_e old_reason = intf->op_state.reason;
+    bool was_enabled = intf->op_state.enabled;
 
     /* Set mtu. */
     set_op_state_mtu(intf);
@@ -1613,43 +2695,275 @@ set_interface_config(const struct ovsrec_interface *ifrow, struct iface *intf)
         set_op_state_duplex(intf);
     }
 
-    /* One interface needs to be reconfigured in h/w. */
-    set_intf_hw_config_in_db(ifrow, intf);
+    if (intf->op_state.enabled != was_enabled
+        || intf->op_state.reason != old_reason) {
+        intfd_history_record(intf, old_reason);
+    }
+    intf->eval_triggers = 0;
+
+    INTFD_PROBE3(intf_evaluated, intf->name, intf->op_state.enabled,
+                 intf->op_state.reason);
+
+} /* intfd_evaluate_intf */
+
+/* Returns the bucket of the cost of 'intf' for the current iteration,
+ * clearing the buckets of the periods 'intf' was not charged in.  Like the
+ * evaluation, only touches 'intf'. */
+static struct intfd_cost_bucket *
+intfd_cost_current(struct iface *intf)
+{
+    struct intfd_cost *cost = intf->cost;
+    long long int epoch;
+
+    if (!cost) {
+        cost = intf->cost = xzalloc(sizeof *cost);
+        cost->epoch = cost_epoch;
+    }
+    for (epoch = cost->epoch + 1;
+         epoch <= cost_epoch && epoch <= cost->epoch + INTFD_COST_N_BUCKETS;
+         epoch++) {
+        memset(&cost->buckets[epoch % INTFD_COST_N_BUCKETS], 0,
+               sizeof cost->buckets[0]);
+    }
+    cost->epoch = MAX(cost->epoch, cost_epoch);
+
+    return &cost->buckets[cost_epoch % INTFD_COST_N_BUCKETS];
+} /* intfd_cost_current */
+
+static void
+intfd_evaluate_cb(void *intf_)
+{
+    struct iface *intf = intf_;
+    struct intfd_cost_bucket *bucket;
+    long long int start;
+
+    if (intf->eval_pending) {
+        start = intfd_perf_start();
+        intfd_evaluate_intf(intf);
+        intf->eval_pending = false;
+
+        bucket = intfd_cost_current(intf);
+        bucket->eval_ns += intfd_perf_start() - start;
+        bucket->n_evals++;
+    }
+} /* intfd_evaluate_cb */
+
+/* Evaluates every queued interface.  Large work sets are spread over the
+ * worker pool; the results are written by intfd_flush_writes() on the
+ * main thread. */
+static void
+intfd_evaluate_pending(void)
+{
+    size_t i;
+
+    if (n_pending_writes >= INTFD_PARALLEL_EVAL_MIN && intfd_workers_count()) {
+        intfd_workers_run(intfd_evaluate_cb, (void **) pending_writes,
+                          n_pending_writes);
+        return;
+    }
+
+    for (i = 0; i < n_pending_writes; i++) {
+        if (pending_writes[i]) {
+            intfd_evaluate_cb(pending_writes[i]);
+        }
+    }
+} /* intfd_evaluate_pending */
+
+/* Stamps the first time a change to the inputs of 'intf' is observed,
+ * which is kept until the resulting write commits.  Changes seen before
+ * the initial configuration has been committed are not tracked. */
+static void
+intfd_latency_observe(struct iface *intf)
+{
+    if (intf->cfg_observed || !system_configured || intfd_staging) {
+        return;
+    }
+    intf->cfg_observed = intfd_perf_start();
+    intf->cfg_seqno = ovsdb_idl_get_seqno(idl);
+} /* intfd_latency_observe */
+
+/* Keeps the transition of 'intf' among the slowest ones if it qualifies,
+ * and logs it. */
+static void
+intfd_latency_rank(const struct iface *intf, long long int latency)
+{
+    struct intfd_transition *t;
+    size_t i;
+
+    if (n_slowest == INTFD_N_SLOWEST_TRANSITIONS) {
+        if (latency <= slowest[n_slowest - 1].latency) {
+            return;
+        }
+        free(slowest[--n_slowest].name);
+    }
+
+    /* Keep 'slowest' sorted from the slowest down. */
+    for (i = n_slowest; i > 0 && slowest[i - 1].latency < latency; i--) {
+        slowest[i] = slowest[i - 1];
+    }
+    t = &slowest[i];
+    t->name = xstrdup(intf->name);
+    t->latency = latency;
+    t->seqno = intf->cfg_seqno;
+    t->when = time_wall_msec();
+    n_slowest++;
+
+    VLOG_INFO("Interface %s: configuration reached the database %lld us "
+              "after it was observed (seqno %u)", intf->name,
+              latency / 1000, intf->cfg_seqno);
+} /* intfd_latency_rank */
+
+/* Records the config to hardware latency of the interfaces written to the
+ * transaction that just committed with 'status'. */
+static void
+intfd_latency_complete(enum ovsdb_idl_txn_status status)
+{
+    long long int now = intfd_perf_start();
+    bool success = (status == TXN_SUCCESS || status == TXN_UNCHANGED);
+    long long int latency;
+    struct iface *intf;
+    size_t i;
+
+    for (i = 0; i < n_txn_inflight; i++) {
+        intf = txn_inflight[i];
+        intfd_snapshot_mark(intf);
+        if (!success) {
+            n_failed_transitions++;
+            intf->cfg_observed = 0;
+            continue;
+        }
+
+        latency = now - intf->cfg_observed;
+        intf->cfg_observed = 0;
+        intf->cfg_n_latency++;
+        intf->cfg_last_latency = latency;
+        intf->cfg_total_latency += latency;
+        if (latency > intf->cfg_max_latency) {
+            intf->cfg_max_latency = latency;
+        }
+        intfd_perf_histogram_record(&cfg_latency, latency);
+        intfd_latency_rank(intf, latency);
+    }
+    n_txn_inflight = 0;
+} /* intfd_latency_complete */
+
+/* Marks the arbiter state of the interfaces whose forwarding state was
+ * written to the transaction that just committed with 'status' as stale
+ * if it failed, and schedules their re-evaluation. */
+static void
+intfd_arbiter_complete(enum ovsdb_idl_txn_status status)
+{
+    size_t i;
+
+    if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+        for (i = 0; i < n_txn_arbiter; i++) {
+            txn_arbiter[i]->arbiter.row_stale = true;
+        }
+        if (n_txn_arbiter && !arbiter_retry_at) {
+            arbiter_retry_at = time_msec() + INTFD_ARBITER_RETRY_MSEC;
+        }
+    }
+    n_txn_arbiter = 0;
+} /* intfd_arbiter_complete */
+
+/* Commits 'intfd_txn', blocking until ovsdb-server replies. */
+static void
+intfd_txn_commit(void)
+{
+    enum ovsdb_idl_txn_status status;
+    long long int perf_start;
+
+    INTFD_PROBE1(commit_start, txn_rows);
+    perf_start = intfd_perf_start();
+    status = ovsdb_idl_txn_commit_block(intfd_txn);
+    intfd_perf_end(INTFD_PERF_COMMIT, perf_start);
+    INTFD_PROBE1(commit_finish, status);
+    intfd_perf_count(INTFD_PERF_COMMITS, 1);
+
+    if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+        VLOG_WARN("Transaction failed: %s",
+                  ovsdb_idl_txn_status_to_string(status));
+    }
+    intfd_latency_complete(status);
+    intfd_arbiter_complete(status);
+} /* intfd_txn_commit */
+
+/* Queues 'intf' for evaluation after a change of its 'triggers' inputs. */
+void
+set_interface_config(const struct ovsrec_interface *ifrow,
+                     struct iface *intf, unsigned int triggers)
+{
+    VLOG_DBG("Received new config for interface %s", ifrow->name);
+
+    intfd_latency_observe(intf);
+    intfd_snapshot_mark(intf);
+    intf->eval_triggers |= triggers;
+
+    /* Evaluation and the write to h/w config happen once all the changes
+     * of this run have been parsed. */
+    intfd_queue_write(intf, ifrow);
 
 } /* set_interface_config */
 
 static int
-handle_interfaces_config_mods(struct shash *sh_idl_interfaces)
+handle_interfaces_config_mods(struct shash *sh_idl_interfaces, bool bulk_loaded)
 {
     int rc = 0;
     int i;
     bool cfg_changed = false;
     bool split_changed = false;
     bool pm_info_changed = false;
+    unsigned int triggers;
+    int n_resync = 0;
+    int n_changed = 0;
     struct intf_user_cfg new_user_cfg;
     struct intf_pm_info new_pm_info;
     struct shash_node *sh_node;
+    struct shash port_map = SHASH_INITIALIZER(&port_map);
     struct iface *intf = NULL;
     const struct ovsrec_interface *ifrow = NULL;
 
     VLOG_DBG("handle_interfaces_config_mods\n");
+    if (idl_resync) {
+        intfd_port_map_build(&port_map);
+    }
     /* Loop through all the current interfaces and handle config changes. */
     SHASH_FOR_EACH(sh_node, &all_interfaces) {
         cfg_changed = false;
+        triggers = 0;
         intf = sh_node->data;
         ifrow = shash_find_data(sh_idl_interfaces, sh_node->name);
 
         if (OVSREC_IDL_IS_ROW_INSERTED(ifrow, idl_seqno)) {
 
-            /* Update parent/child relationship if needed. */
-            intfd_process_parent_child(intf, ifrow);
+            n_changed++;
+            INTFD_PROBE2(row_changed, ifrow->name, 1);
+            if (idl_resync) {
+                /* Row re-sent after a reconnect. Refresh the cached inputs;
+                 * only outputs that differ from the row get written. */
+                intfd_refresh_intf(intf, ifrow, &port_map);
+                intf->arbiter.evaluated = false;
+                n_resync++;
+            }
+            intfd_queue_arbiter(intf, ifrow);
+
+            /* Update parent/child relationship if needed.
+             * intfd_bulk_load() has already resolved them. */
+            if (!bulk_loaded) {
+                intfd_process_parent_child(intf, ifrow);
+            }
 
-            set_interface_config(ifrow, intf);
+            set_interface_config(ifrow, intf, INTFD_TRIGGER_ADDED);
             rc++;
 
         } else if (OVSREC_IDL_IS_ROW_MODIFIED(ifrow, idl_seqno)) {
 
             VLOG_DBG("Something got modified\n");
+            n_changed++;
+            INTFD_PROBE2(row_changed, ifrow->name, 0);
+            /* e.g. bond_status */
+            intfd_queue_arbiter(intf, ifrow);
+
             intfd_parse_user_cfg(&new_user_cfg, &ifrow->user_config,
                                  &ifrow->hw_intf_info);
 
@@ -1665,77 +2979,93 @@ handle_interfaces_config_mods(struct shash *sh_idl_interfaces)
 
             if (intf->user_cfg.admin_state != new_user_cfg.admin_state) {
                 cfg_changed = true;
+                triggers |= INTFD_TRIGGER_USER_CONFIG;
                 intf->user_cfg.admin_state = new_user_cfg.admin_state;
             }
 
             if (intf->user_cfg.autoneg != new_user_cfg.autoneg) {
                 cfg_changed = true;
+                triggers |= INTFD_TRIGGER_USER_CONFIG;
                 intf->user_cfg.autoneg = new_user_cfg.autoneg;
             }
 
             if (intf->user_cfg.pause != new_user_cfg.pause) {
                 cfg_changed = true;
+                triggers |= INTFD_TRIGGER_USER_CONFIG;
                 intf->user_cfg.pause = new_user_cfg.pause;
             }
 
             if (intf->user_cfg.duplex != new_user_cfg.duplex) {
                 cfg_changed = true;
+                triggers |= INTFD_TRIGGER_USER_CONFIG;
                 intf->user_cfg.duplex = new_user_cfg.duplex;
             }
 
             if (intf->user_cfg.mtu != new_user_cfg.mtu) {
                 cfg_changed = true;
+                triggers |= INTFD_TRIGGER_USER_CONFIG;
                 intf->user_cfg.mtu = new_user_cfg.mtu;
             }
 
             for (i = 0; i < INTFD_MAX_SPEEDS_ALLOWED; i++) {
                 if (intf->user_cfg.speeds[i] != new_user_cfg.speeds[i]) {
                     cfg_changed = true;
+                    triggers |= INTFD_TRIGGER_USER_CONFIG;
                     intf->user_cfg.speeds[i] = new_user_cfg.speeds[i];
                 }
             }
 
             if (intf->user_cfg.n_speeds != new_user_cfg.n_speeds) {
                 cfg_changed = true;
+                triggers |= INTFD_TRIGGER_USER_CONFIG;
                 intf->user_cfg.n_speeds = new_user_cfg.n_speeds;
             }
 
             if (intf->user_cfg.lane_split != new_user_cfg.lane_split) {
                 cfg_changed = true;
                 split_changed = true;
+                triggers |= INTFD_TRIGGER_SPLIT;
                 intf->user_cfg.lane_split = new_user_cfg.lane_split;
             }
 
             if (intf->pm_info.connector != new_pm_info.connector) {
                 cfg_changed = true;
                 pm_info_changed = true;
+                triggers |= INTFD_TRIGGER_PM_INFO;
                 intf->pm_info.connector = new_pm_info.connector;
             }
 
             if (intf->pm_info.connector_status != new_pm_info.connector_status) {
                 cfg_changed = true;
+                triggers |= INTFD_TRIGGER_PM_INFO;
                 intf->pm_info.connector_status = new_pm_info.connector_status;
             }
 
             if (intf->pm_info.intf_type != new_pm_info.intf_type) {
                 cfg_changed = true;
+                triggers |= INTFD_TRIGGER_PM_INFO;
                 intf->pm_info.intf_type = new_pm_info.intf_type;
             }
 
             if (intf->pm_info.op_connector_flags != new_pm_info.op_connector_flags) {
                 cfg_changed = true;
+                triggers |= INTFD_TRIGGER_PM_INFO;
                 intf->pm_info.op_connector_flags = new_pm_info.op_connector_flags;
             }
 
             VLOG_DBG("cfg_changed = %d\n", cfg_changed);
             if (cfg_changed) {
+                COVERAGE_INC(intfd_cfg_changed);
                 /* Update interface configuration. */
-                set_interface_config(ifrow, intf);
+                set_interface_config(ifrow, intf, triggers);
                 rc++;
             }
 
             /* If parent port's connector is changed, pass on
              * the change to split children. */
+            if (pm_info_changed) {
+                COVERAGE_INC(intfd_pm_info_changed);
+            }
             if (pm_info_changed && ifrow->split_children) {
                 int i;
                 for (i = 0; i < intf->n_split_children; i++) {
@@ -1749,14 +3079,23 @@ handle_interfaces_config_mods(struct shash *sh_idl_interfaces)
                 int i;
                 /* Lane split status changed.  Need to
                  * reconfigure all split children as well. */
+                COVERAGE_INC(intfd_split_propagated);
                 for (i = 0; i < intf->n_split_children; i++) {
                     set_interface_config(ifrow->split_children[i],
-                                         intf->split_children[i]);
+                                         intf->split_children[i],
+                                         INTFD_TRIGGER_SPLIT
+                                         | (triggers & INTFD_TRIGGER_PM_INFO));
                 }
             }
         }
     }
 
+    shash_destroy(&port_map);
+    if (n_resync) {
+        VLOG_INFO("Reconciling %d interfaces after reconnect", n_resync);
+    }
+    intfd_perf_count(INTFD_PERF_ROWS_CHANGED, n_changed);
+
     return rc;
 
 } /* handle_interfaces_config_mods */
@@ -1803,6 +3142,7 @@ add_del_interface_handle_port_config_mods(void)
                     VLOG_DBG("Port cache is NULL\n");
                     continue;
                 }
+                COVERAGE_INC(intfd_port_admin_changed);
 
                 for (i = 0; i < port_row->n_interfaces; i++)
                 {
@@ -1823,11 +3163,11 @@ add_del_interface_handle_port_config_mods(void)
                                     INTERFACE_USER_CONFIG_MAP_ADMIN);
                     if (data && (STR_EQ(data, OVSREC_INTERFACE_USER_CONFIG_ADMIN_UP))) {
                         intf->user_cfg.admin_state = INTERFACE_USER_CONFIG_ADMIN_UP;
-                        log_event("INTERFACE_UP", EV_KV("interface", intf->name));
+                        intfd_eventlog_post(INTFD_EVENT_INTERFACE_UP, intf->name);
                     } else {
-                        log_event("INTERFACE_DOWN", EV_KV("interface", intf->name));
+                        intfd_eventlog_post(INTFD_EVENT_INTERFACE_DOWN, intf->name);
                     }
-                    set_interface_config(intf_row, intf);
+                    set_interface_config(intf_row, intf, INTFD_TRIGGER_PORT);
                     rc++;
                 }
                 rc |= remove_interface_from_port(port_row);
@@ -1855,7 +3195,6 @@ remove_interface_from_port(const struct ovsrec_port *port_row)
     int rc = 0, i, j;
     int found;
     const struct ovsrec_interface *intf_row = NULL;
-    struct smap hw_cfg_smap;
     struct port_info *port_data;
     struct iface *intf;
 
@@ -1874,18 +3213,16 @@ remove_interface_from_port(const struct ovsrec_port *port_row)
         for(j = 0; j < port_data->n_interfaces; j++) {
             intf_row = port_data->interface[j];
             intf = shash_find_data(&all_interfaces, intf_row->name);
+            if (!intf) {
+                continue;
+            }
             if (port_parse_admin(&intf->port_admin, intf_row)) {
                 intf->user_cfg.admin_state = intf_parse_admin(intf_row);
                 VLOG_INFO("Set the new admin state based on the port state\n");
-                set_interface_config(intf_row, intf);
+                set_interface_config(intf_row, intf, INTFD_TRIGGER_PORT);
             } else {
                 VLOG_DBG("reset interface %s\n", intf_row->name);
-                smap_init(&hw_cfg_smap);
-                smap_add(&hw_cfg_smap,
-                        INTERFACE_HW_INTF_CONFIG_MAP_ENABLE,
-                        INTERFACE_HW_INTF_CONFIG_MAP_ENABLE_FALSE);
-                ovsrec_interface_set_hw_intf_config(intf_row, &hw_cfg_smap);
-                smap_destroy(&hw_cfg_smap);
+                intfd_queue_reset(intf, intf_row);
             }
         }
         rc++;
@@ -1903,20 +3240,16 @@ remove_interface_from_port(const struct ovsrec_port *port_row)
         if(!found) {
             /* Reset the inetrface admin state */
             VLOG_DBG("deleting interface from port\n");
+            COVERAGE_INC(intfd_port_member_removed);
             intf_row = port_data->interface[j];
             intf = shash_find_data(&all_interfaces, intf_row->name);
             if (intf && port_parse_admin(&intf->port_admin, intf_row)) {
                 VLOG_INFO("Set the new admin state based on the port state\n");
                 intf->user_cfg.admin_state = intf_parse_admin(intf_row);
-                set_interface_config(intf_row, intf);
-            } else {
+                set_interface_config(intf_row, intf, INTFD_TRIGGER_PORT);
+            } else if (intf) {
                 VLOG_DBG("reset interface %s\n", intf_row->name);
-                smap_init(&hw_cfg_smap);
-                smap_add(&hw_cfg_smap,
-                        INTERFACE_HW_INTF_CONFIG_MAP_ENABLE,
-                        INTERFACE_HW_INTF_CONFIG_MAP_ENABLE_FALSE);
-                ovsrec_interface_set_hw_intf_config(intf_row, &hw_cfg_smap);
-                smap_destroy(&hw_cfg_smap);
+                intfd_queue_reset(intf, intf_row);
             }
             rc++;
 
@@ -1934,6 +3267,10 @@ port_reconfigure(void)
     struct shash sh_idl_ports;
     struct shash_node *sh_node = NULL, *sh_next = NULL;
 
+    if (idl_resync) {
+        intfd_resync_ports();
+    }
+
     port_row = ovsrec_port_first(idl);
 
     /* if its not a port related operation then do not go ahead */
@@ -1953,6 +3290,7 @@ port_reconfigure(void)
 
     /* Collect all the interfaces in the dB. */
     shash_init(&sh_idl_ports);
+    hmap_reserve(&sh_idl_ports.map, shash_count(&all_ports));
     OVSREC_PORT_FOR_EACH(port_row, idl) {
         if (!shash_add_once(&sh_idl_ports, port_row->name, port_row)) {
             VLOG_WARN("interface %s specified twice", port_row->name);
@@ -2002,30 +3340,274 @@ end:
     return rc;
 } /* intfd_reconfigure */
 
+/* Accounts for one more row written to 'intfd_txn'.  A row is only
+ * accounted once, however many of its columns are written. */
+static void
+intfd_txn_row_written(void)
+{
+    intfd_perf_count(INTFD_PERF_ROWS_WRITTEN, 1);
+    txn_rows++;
+} /* intfd_txn_row_written */
+
+/* Makes room in 'intfd_txn' for the row of the next interface, which
+ * holds all of its outputs.  If 'txn_max_rows' rows have already been
+ * written to it, commits it and opens a new one first.
+ *
+ * Returns true if it committed.  The IDL has run while committing, so the
+ * caller must not use any row pointer obtained before the call. */
+static bool
+intfd_txn_reserve(void)
+{
+    if (!txn_max_rows || txn_rows < txn_max_rows) {
+        return false;
+    }
+
+    VLOG_DBG("Committing a chunk of %u rows", txn_rows);
+    intfd_txn_commit();
+    ovsdb_idl_txn_destroy(intfd_txn);
+    intfd_txn = ovsdb_idl_txn_create(idl);
+    txn_rows = 0;
+    txn_chunks++;
+
+    return true;
+
+} /* intfd_txn_reserve */
+
+/* Runs the arbiter for 'intf', whose row is 'ifrow', and takes it off
+ * the arbiter queue.  The forwarding state is only re-evaluated if the
+ * arbiter inputs differ from the ones of its last evaluation.
+ *
+ * Returns true if the forwarding state was written.  The caller accounts
+ * for the row. */
+static bool
+intfd_arbiter_intf(struct iface *intf, const struct ovsrec_interface *ifrow,
+                   long long int now)
+{
+    bool written = false;
+
+    if (intf->arbiter_pending) {
+        pending_arbiter[intf->arbiter_idx] = NULL;
+        intf->arbiter_pending = false;
+    }
+
+    if (!intfd_arbiter_update_inputs(ifrow, &intf->arbiter, now)) {
+        return false;
+    }
+
+    /* It only writes the keys of the forwarding state that changed. */
+    if (intfd_arbiter_interface_run(ifrow, &intf->arbiter, now)) {
+        intfd_cost_current(intf)->n_writes++;
+        if (n_txn_arbiter >= allocated_txn_arbiter) {
+            txn_arbiter = x2nrealloc(txn_arbiter, &allocated_txn_arbiter,
+                                     sizeof *txn_arbiter);
+        }
+        txn_arbiter[n_txn_arbiter++] = intf;
+        written = true;
+    }
+    if (intf->arbiter.hold_until
+        && (!arbiter_hold_until
+            || intf->arbiter.hold_until < arbiter_hold_until)) {
+        arbiter_hold_until = intf->arbiter.hold_until;
+    }
+
+    return written;
+
+} /* intfd_arbiter_intf */
+
+/* Writes the state of the queued interfaces to OVSDB, in queue order and
+ * in transactions of at most 'txn_max_rows' rows.  The forwarding state
+ * of an interface written here is arbitrated right away, so that its
+ * H/W config, error and forwarding state always go into the same
+ * transaction, as a single row.  Rows are looked up by UUID since a
+ * chunk commit may have changed the IDL.
+ *
+ * Returns the number of H/W configs written. */
+static int
+intfd_flush_writes(void)
+{
+    const struct ovsrec_interface *ifrow;
+    struct iface *intf;
+    long long int now = time_msec();
+    int n_written = 0;
+    bool written;
+    size_t i;
+
+    for (i = 0; i < n_pending_writes; i++) {
+        intf = pending_writes[i];
+        if (!intf) {
+            continue;
+        }
+        intf->write_pending = false;
+
+        intfd_txn_reserve();
+        ifrow = ovsrec_interface_get_for_uuid(idl, &intf->row_uuid);
+        if (!ifrow) {
+            written = false;
+        } else if (intf->reset_pending) {
+            written = intfd_reset_hw_config_in_db(ifrow);
+        } else {
+            written = set_intf_hw_config_in_db(ifrow, intf);
+        }
+        intf->reset_pending = false;
+
+        if (written) {
+            INTFD_PROBE1(write_emitted, ifrow->name);
+            COVERAGE_INC(intfd_write_emitted);
+            intfd_cost_current(intf)->n_writes++;
+            n_written++;
+            if (intf->cfg_observed) {
+                if (n_txn_inflight >= allocated_txn_inflight) {
+                    txn_inflight = x2nrealloc(txn_inflight,
+                                              &allocated_txn_inflight,
+                                              sizeof *txn_inflight);
+                }
+                txn_inflight[n_txn_inflight++] = intf;
+            }
+            intfd_txn_row_written();
+
+            /* hw_intf_config:enable is an arbiter input.  The forwarding
+             * state goes into the row already accounted for. */
+            intfd_snapshot_mark(intf);
+            intfd_arbiter_intf(intf, ifrow, now);
+        } else {
+            /* Nothing to write, so no transition to measure. */
+            COVERAGE_INC(intfd_write_suppressed);
+            intf->cfg_observed = 0;
+        }
+    }
+    n_pending_writes = 0;
+
+    return n_written;
+
+} /* intfd_flush_writes */
+
+/* Updates the forwarding states of each layer and the final forwarding
+ * state of the interfaces still queued after intfd_flush_writes(). */
 static int
 intfd_arbiter_run(void)
 {
     int rc = 0;
     const struct ovsrec_interface *ifrow = NULL;
-    struct smap forwarding_state;
+    struct iface *intf;
+    long long int now = time_msec();
+    size_t i;
 
-    /* Walk through all the interfaces and update the forwarding states
-     * for each layer and the final forwarding state. */
-    OVSREC_INTERFACE_FOR_EACH(ifrow, idl) {
-        smap_clone(&forwarding_state, &ifrow->forwarding_state);
-        /* Run arbiter for the interface */
-        intfd_arbiter_interface_run(ifrow, &forwarding_state);
-        /* Check if the OVSDB column needs an update */
-        if (!smap_equal(&forwarding_state, &ifrow->forwarding_state)) {
-            ovsrec_interface_set_forwarding_state(ifrow, &forwarding_state);
+    for (i = 0; i < n_pending_arbiter; i++) {
+        intf = pending_arbiter[i];
+        if (!intf) {
+            continue;
+        }
+
+        intfd_txn_reserve();
+        ifrow = ovsrec_interface_get_for_uuid(idl, &intf->row_uuid);
+        if (!ifrow) {
+            pending_arbiter[i] = NULL;
+            intf->arbiter_pending = false;
+            continue;
+        }
+
+        if (intfd_arbiter_intf(intf, ifrow, now)) {
+            intfd_txn_row_written();
             rc = 1;
         }
-        smap_destroy(&forwarding_state);
     }
+    n_pending_arbiter = 0;
 
     return rc;
 }
 
+/* Queues the interfaces whose arbiter hold timer expired, and schedules
+ * the next expiry. */
+static void
+intfd_expire_arbiter_holds(void)
+{
+    const struct ovsrec_interface *ifrow;
+    struct shash_node *sh_node;
+    long long int now = time_msec();
+
+    if (!arbiter_hold_until || now < arbiter_hold_until) {
+        return;
+    }
+
+    arbiter_hold_until = 0;
+    SHASH_FOR_EACH(sh_node, &all_interfaces) {
+        struct iface *intf = sh_node->data;
+        long long int hold_until = intf->arbiter.hold_until;
+
+        if (!hold_until) {
+            continue;
+        }
+        if (now >= hold_until) {
+            ifrow = ovsrec_interface_get_for_uuid(idl, &intf->row_uuid);
+            if (ifrow) {
+                intfd_queue_arbiter(intf, ifrow);
+            }
+        } else if (!arbiter_hold_until || hold_until < arbiter_hold_until) {
+            arbiter_hold_until = hold_until;
+        }
+    }
+
+} /* intfd_expire_arbiter_holds */
+
+/* Queues again, once their retry time has come, the interfaces whose
+ * forwarding state failed to commit.  The arbiter then compares their
+ * result with the forwarding state column instead of the last result. */
+static void
+intfd_retry_arbiter(void)
+{
+    const struct ovsrec_interface *ifrow;
+    struct shash_node *sh_node;
+
+    if (!arbiter_retry_at || time_msec() < arbiter_retry_at) {
+        return;
+    }
+
+    arbiter_retry_at = 0;
+    SHASH_FOR_EACH(sh_node, &all_interfaces) {
+        struct iface *intf = sh_node->data;
+
+        if (intf->arbiter.row_stale) {
+            ifrow = ovsrec_interface_get_for_uuid(idl, &intf->row_uuid);
+            if (ifrow) {
+                intfd_queue_arbiter(intf, ifrow);
+            }
+        }
+    }
+
+} /* intfd_retry_arbiter */
+
+/* Re-validates the user MTU of every interface against a new subsystem
+ * MTU.  Only interfaces whose parsed MTU changes are re-evaluated. */
+static int
+intfd_rescan_subsystem_mtu(struct shash *sh_idl_interfaces)
+{
+    int rc = 0;
+    struct intf_user_cfg new_user_cfg;
+    struct shash_node *sh_node;
+    const struct ovsrec_interface *ifrow;
+
+    COVERAGE_INC(intfd_mtu_rescan);
+    SHASH_FOR_EACH(sh_node, &all_interfaces) {
+        struct iface *intf = sh_node->data;
+
+        ifrow = shash_find_data(sh_idl_interfaces, sh_node->name);
+        if (!ifrow) {
+            continue;
+        }
+
+        intfd_parse_user_cfg(&new_user_cfg, &ifrow->user_config,
+                             &ifrow->hw_intf_info);
+        if (new_user_cfg.mtu != intf->user_cfg.mtu) {
+            intf->user_cfg.mtu = new_user_cfg.mtu;
+            set_interface_config(ifrow, intf, INTFD_TRIGGER_SUBSYSTEM);
+            rc++;
+        }
+    }
+
+    return rc;
+
+} /* intfd_rescan_subsystem_mtu */
+
 static int
 intfd_reconfigure(void)
 {
@@ -2035,6 +3617,9 @@ intfd_reconfigure(void)
     unsigned int new_idl_seqno = 0;
     struct shash sh_idl_interfaces;
     struct shash_node *sh_node = NULL, *sh_next = NULL;
+    int32_t old_subsys_mtu = base_subsys.mtu;
+    bool bulk_loaded = false;
+    long long int perf_start;
 
     new_idl_seqno = ovsdb_idl_get_seqno(idl);
     if (new_idl_seqno == idl_seqno) {
@@ -2069,8 +3654,15 @@ intfd_reconfigure(void)
         }
     }
 
+    /* Initial population of the interfaces. */
+    if (shash_is_empty(&all_interfaces)) {
+        intfd_bulk_load();
+        bulk_loaded = true;
+    }
+
     /* Collect all the interfaces in the dB. */
     shash_init(&sh_idl_interfaces);
+    hmap_reserve(&sh_idl_interfaces.map, shash_count(&all_interfaces));
     OVSREC_INTERFACE_FOR_EACH(ifrow, idl) {
         if (!shash_add_once(&sh_idl_interfaces, ifrow->name, ifrow)) {
             VLOG_WARN("interface %s specified twice", ifrow->name);
@@ -2097,14 +3689,23 @@ intfd_reconfigure(void)
         }
     }
 
+    perf_start = intfd_perf_start();
     rc = port_reconfigure();
+    intfd_perf_end(INTFD_PERF_PORT_RECONFIGURE, perf_start);
     VLOG_DBG("After port reconfigure rc = %d\n", rc);
 
     /* Process interface config changes. */
-    rc |= handle_interfaces_config_mods(&sh_idl_interfaces);
+    perf_start = intfd_perf_start();
+    rc |= handle_interfaces_config_mods(&sh_idl_interfaces, bulk_loaded);
+    intfd_perf_end(INTFD_PERF_CONFIG_MODS, perf_start);
+
+    /* The subsystem MTU bounds the valid user MTU of every interface. */
+    if (base_subsys.mtu != old_subsys_mtu) {
+        VLOG_DBG("Subsystem MTU changed from %d to %d",
+                 old_subsys_mtu, base_subsys.mtu);
+        rc |= intfd_rescan_subsystem_mtu(&sh_idl_interfaces);
+    }
 
-    /* Determine the new 'forwarding state' for each interface */
-    rc |= intfd_arbiter_run();
 
     /* Update idl_seqno after handling all OVSDB updates. */
     idl_seqno = new_idl_seqno;
@@ -2129,6 +3730,7 @@ intfd_system_is_configured(void)
     if (sysrow && sysrow->cur_cfg > INT64_C(0)) {
         VLOG_DBG("System now configured (cur_cfg=%" PRId64 ").",
                  sysrow->cur_cfg);
+        startup_stats.cur_cfg_msec = time_msec();
         return (system_configured = true);
     }
 
@@ -2138,10 +3740,17 @@ intfd_system_is_configured(void)
 void
 intfd_run(void)
 {
-    struct ovsdb_idl_txn *txn;
+    long long int iter_start, perf_start;
+    bool resync;
+    int n_written;
+    int rc;
 
     /* Process a batch of messages from OVSDB. */
+    iter_start = intfd_perf_start();
+    cost_epoch = iter_start / INTFD_COST_BUCKET_NS;
     ovsdb_idl_run(idl);
+    intfd_perf_end(INTFD_PERF_IDL_RUN, iter_start);
+    intfd_record_run(idl);
 
     if (ovsdb_idl_is_lock_contended(idl)) {
         static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 1);
@@ -2154,27 +3763,413 @@ intfd_run(void)
         return;
     }
 
-    /* Nothing to do until system has been configured, i.e., cur_cfg > 0. */
+    /* A new session with ovsdb-server re-sends every row as inserted, and
+     * the rows of the previous session are freed.  The lock is granted
+     * before the rows arrive, so look at the rows themselves: the System
+     * row is only ever inserted by the first contents of a session.
+     * Reconcile against the cached state instead of rewriting everything. */
+    if (!shash_is_empty(&all_interfaces)
+        && OVSREC_IDL_IS_ROW_INSERTED(ovsrec_system_first(idl), idl_seqno)) {
+        VLOG_INFO("OVSDB session re-established, resyncing interfaces");
+        idl_resync = true;
+    }
+
+    /* Until the system has been configured, i.e., cur_cfg > 0, only build
+     * and evaluate the local state.  Every write, including the resets of
+     * the port members, stays queued until the first commit. */
     if (!intfd_system_is_configured()) {
+        intfd_reconfigure();
+        idl_resync = false;
+        intfd_evaluate_pending();
+        intfd_snapshot_publish();
+        return;
+    }
+
+    intfd_expire_arbiter_holds();
+    intfd_retry_arbiter();
+
+    /* Nothing changed since the last run. */
+    if (ovsdb_idl_get_seqno(idl) == idl_seqno && !n_pending_writes
+        && !n_pending_arbiter && !intfd_staging) {
         return;
     }
 
+    if (intfd_staging) {
+        startup_stats.n_staged = intfd_count_pending_writes();
+    }
+
     /* Update the local configuration and push any changes to the dB. */
-    txn = ovsdb_idl_txn_create(idl);
-    if (intfd_reconfigure()) {
+    intfd_txn = ovsdb_idl_txn_create(idl);
+    txn_rows = txn_chunks = 0;
+    resync = idl_resync;
+
+    rc = intfd_reconfigure();
+    idl_resync = false;
+    perf_start = intfd_perf_start();
+    intfd_evaluate_pending();
+    intfd_perf_end(INTFD_PERF_EVALUATE, perf_start);
+
+    /* Write the evaluated interfaces, then determine the new 'forwarding
+     * state' of each interface from what has been written. */
+    perf_start = intfd_perf_start();
+    n_written = intfd_flush_writes();
+    intfd_perf_end(INTFD_PERF_FLUSH, perf_start);
+    rc |= n_written;
+    perf_start = intfd_perf_start();
+    rc |= intfd_arbiter_run();
+    intfd_perf_end(INTFD_PERF_ARBITER, perf_start);
+
+    if (rc || txn_rows) {
         VLOG_DBG("Commiting changes\n");
         /* Some OVSDB write needs to happen. */
-        ovsdb_idl_txn_commit_block(txn);
+        intfd_txn_commit();
+    }
+    ovsdb_idl_txn_destroy(intfd_txn);
+    intfd_txn = NULL;
+
+    if (intfd_staging) {
+        /* First run after cur_cfg: everything evaluated so far has just
+         * been pushed. */
+        intfd_staging = false;
+        startup_stats.n_written = n_written;
+        startup_stats.n_txns = txn_chunks + (txn_rows ? 1 : 0);
+        startup_stats.first_commit_msec = time_msec();
+        snapshot_dirty = true;
+        VLOG_INFO("Initial configuration of %"PRIuSIZE" interfaces committed "
+                  "%lld ms after cur_cfg", startup_stats.n_staged,
+                  startup_stats.first_commit_msec - startup_stats.cur_cfg_msec);
+    }
+
+    /* Publish what has just been committed. */
+    perf_start = intfd_perf_start();
+    intfd_snapshot_publish();
+    intfd_perf_end(INTFD_PERF_SNAPSHOT, perf_start);
+    intfd_perf_end(INTFD_PERF_ITERATION, iter_start);
+
+    if (resync) {
+        VLOG_INFO("Resync complete, %d interfaces rewritten", n_written);
     }
-    ovsdb_idl_txn_destroy(txn);
 
     return;
 } /* intfd_run */
 
+/* The statistics dumps below read the published state snapshot, so they
+ * may run on any thread. */
+
+void
+intfd_startup_stats_dump(struct ds *ds)
+{
+    struct intfd_snapshot *snap = intfd_snapshot_get();
+    const struct intfd_startup_stats *stats = &snap->startup_stats;
+
+    ds_put_format(ds, "Interfaces staged before cur_cfg  : %"PRIuSIZE"\n",
+                  stats->n_staged);
+    if (!stats->first_commit_msec) {
+        ds_put_cstr(ds, "Initial commit                    : pending\n");
+    } else {
+        ds_put_format(ds, "Rows written by initial commit    : %"PRIuSIZE"\n",
+                      stats->n_written);
+        ds_put_format(ds, "Transactions for initial commit   : %u\n",
+                      stats->n_txns);
+        ds_put_format(ds, "cur_cfg to initial commit         : %lld ms\n",
+                      stats->first_commit_msec - stats->cur_cfg_msec);
+    }
+    intfd_snapshot_unref(snap);
+} /* intfd_startup_stats_dump */
+
+static void
+intfd_latency_dump_intf(struct ds *ds, const struct intfd_snapshot_intf *intf)
+{
+    ds_put_format(ds, "Interface %s:\n", intf->name);
+    ds_put_format(ds, "    transitions        : %llu\n", intf->cfg_n_latency);
+    if (intf->cfg_n_latency) {
+        ds_put_format(ds, "    last               : %lld us\n",
+                      intf->cfg_last_latency / 1000);
+        ds_put_format(ds, "    mean               : %llu us\n",
+                      intf->cfg_total_latency / 1000 / intf->cfg_n_latency);
+        ds_put_format(ds, "    max                : %lld us\n",
+                      intf->cfg_max_latency / 1000);
+    }
+} /* intfd_latency_dump_intf */
+
+void
+intfd_latency_dump(struct ds *ds, const char *interface_name)
+{
+    struct intfd_snapshot *snap = intfd_snapshot_get();
+    const struct intfd_transition *t;
+    ssize_t idx;
+    size_t i;
+
+    if (interface_name) {
+        idx = intfd_snapshot_find(snap, interface_name);
+        if (idx < 0) {
+            ds_put_format(ds, "Interface %s not found\n", interface_name);
+        } else {
+            intfd_latency_dump_intf(ds, snap->intfs[idx]);
+        }
+        intfd_snapshot_unref(snap);
+        return;
+    }
+
+    ds_put_format(ds, "Transitions                       : %llu\n",
+                  snap->cfg_latency.count);
+    ds_put_format(ds, "Failed transitions                : %u\n",
+                  snap->n_failed_transitions);
+    ds_put_format(ds, "Latency p50                       : %llu us\n",
+                  intfd_perf_histogram_percentile(&snap->cfg_latency, 50)
+                  / 1000);
+    ds_put_format(ds, "Latency p99                       : %llu us\n",
+                  intfd_perf_histogram_percentile(&snap->cfg_latency, 99)
+                  / 1000);
+    ds_put_format(ds, "Latency max                       : %llu us\n",
+                  snap->cfg_latency.max / 1000);
+
+    ds_put_cstr(ds, "\nSlowest transitions:\n");
+    for (i = 0; i < snap->n_slowest; i++) {
+        t = &snap->slowest[i];
+        ds_put_format(ds, "    %-16s %10lld us  seqno %-8u ", t->name,
+                      t->latency / 1000, t->seqno);
+        ds_put_strftime_msec(ds, "%Y-%m-%d %H:%M:%S.###", t->when, false);
+        ds_put_cstr(ds, "\n");
+    }
+
+    ds_put_format(ds, "\n%-16s %8s %10s %10s %10s\n", "Interface",
+                  "count", "last us", "mean us", "max us");
+    for (i = 0; i < snap->n_intfs; i++) {
+        const struct intfd_snapshot_intf *intf = snap->intfs[i];
+
+        if (!intf->cfg_n_latency) {
+            continue;
+        }
+        ds_put_format(ds, "%-16s %8llu %10lld %10llu %10lld\n", intf->name,
+                      intf->cfg_n_latency, intf->cfg_last_latency / 1000,
+                      intf->cfg_total_latency / 1000 / intf->cfg_n_latency,
+                      intf->cfg_max_latency / 1000);
+    }
+    intfd_snapshot_unref(snap);
+} /* intfd_latency_dump */
+
+/* Appends the op state transitions of 'interface_name' to 'ds', oldest
+ * first. */
+void
+intfd_history_dump(struct ds *ds, const char *interface_name)
+{
+    struct intfd_snapshot *snap = intfd_snapshot_get();
+    const struct intfd_snapshot_intf *intf;
+    const struct intfd_history_entry *entry;
+    unsigned long long int i, first;
+    long long int now;
+    ssize_t idx;
+    size_t j;
+
+    idx = intfd_snapshot_find(snap, interface_name);
+    if (idx < 0) {
+        ds_put_format(ds, "Interface %s not found\n", interface_name);
+        intfd_snapshot_unref(snap);
+        return;
+    }
+    intf = snap->intfs[idx];
+
+    first = (intf->n_history > INTFD_HISTORY_LEN
+             ? intf->n_history - INTFD_HISTORY_LEN : 0);
+    ds_put_format(ds, "Interface %s: %llu transitions, last %llu shown\n",
+                  intf->name, intf->n_history, intf->n_history - first);
+    ds_put_format(ds, "%14s %12s  %-22s %-22s %s\n", "Time (s)", "Age (ms)",
+                  "From", "To", "Triggers");
+
+    now = intfd_perf_start();
+    for (i = first; i < intf->n_history; i++) {
+        entry = &intf->history[i % INTFD_HISTORY_LEN];
+        ds_put_format(ds, "%14.6f %12.3f  %-22s %-22s ",
+                      entry->when / 1e9, (now - entry->when) / 1e6,
+                      intfd_get_error_str(entry->old_reason),
+                      intfd_get_error_str(entry->new_reason));
+        if (!entry->triggers) {
+            ds_put_cstr(ds, "-");
+        }
+        for (j = 0; j < ARRAY_SIZE(trigger_names); j++) {
+            if (entry->triggers & (1u << j)) {
+                ds_put_format(ds, "%s%s", trigger_names[j],
+                              entry->triggers >> (j + 1) ? "," : "");
+            }
+        }
+        ds_put_cstr(ds, "\n");
+    }
+    intfd_snapshot_unref(snap);
+} /* intfd_history_dump */
+
+/* Windows of intfd_top_dump(), of the time of the last 'n_buckets'
+ * buckets of cost. */
+static const struct {
+    const char *name;
+    int n_buckets;
+} cost_windows[] = {
+    {"10s", 1},
+    {"1m", 6},
+    {"5m", 30},
+};
+
+/* The cost of an interface over a window. */
+struct intfd_cost_sum {
+    double eval_ns;
+    double n_evals;
+    double n_writes;
+};
+
+struct intfd_top_entry {
+    const struct intfd_snapshot_intf *intf;
+    double key;                         /* Time in the sorting window. */
+    struct intfd_cost_sum sums[ARRAY_SIZE(cost_windows)];
+};
+
+/* Adds to 'sum' the cost of 'cost' over the 'n_buckets' * 10 s before
+ * 'now'.  The window starts within its oldest bucket, which is weighed by
+ * the part of it that is inside. */
+static void
+intfd_cost_window(const struct intfd_cost *cost, long long int now,
+                  int n_buckets, struct intfd_cost_sum *sum)
+{
+    const struct intfd_cost_bucket *bucket;
+    long long int epoch = now / INTFD_COST_BUCKET_NS;
+    double weight;
+    int i;
+
+    for (i = 0; i <= n_buckets; i++) {
+        /* Buckets after the last one charged are stale. */
+        if (epoch - i > cost->epoch
+            || epoch - i <= cost->epoch - INTFD_COST_N_BUCKETS) {
+            continue;
+        }
+
+        bucket = &cost->buckets[(epoch - i) % INTFD_COST_N_BUCKETS];
+        weight = (i < n_buckets ? 1.0
+                  : 1.0 - (double) (now % INTFD_COST_BUCKET_NS)
+                          / INTFD_COST_BUCKET_NS);
+        sum->eval_ns += weight * bucket->eval_ns;
+        sum->n_evals += weight * bucket->n_evals;
+        sum->n_writes += weight * bucket->n_writes;
+    }
+} /* intfd_cost_window */
+
+static int
+intfd_top_compare(const void *a_, const void *b_)
+{
+    const struct intfd_top_entry *a = a_;
+    const struct intfd_top_entry *b = b_;
+
+    if (a->key != b->key) {
+        return a->key < b->key ? 1 : -1;
+    }
+    return strcmp(a->intf->name, b->intf->name);
+} /* intfd_top_compare */
+
+static void
+intfd_top_put_sums(struct ds *ds, const char *name,
+                   const struct intfd_cost_sum *sums)
+{
+    size_t i;
+
+    ds_put_format(ds, "%-16s", name);
+    for (i = 0; i < ARRAY_SIZE(cost_windows); i++) {
+        ds_put_format(ds, "  %10.0f %7.0f %7.0f", sums[i].eval_ns / 1000,
+                      sums[i].n_evals, sums[i].n_writes);
+    }
+    ds_put_cstr(ds, "\n");
+} /* intfd_top_put_sums */
+
+/* Appends to 'ds' the 'n' interfaces that took the most evaluation time
+ * over 'window', one of "10s", "1m" or "5m", with their evaluations and
+ * writes over each window.  Returns false if 'window' is unknown. */
+bool
+intfd_top_dump(struct ds *ds, size_t n, const char *window)
+{
+    struct intfd_cost_sum totals[ARRAY_SIZE(cost_windows)];
+    struct intfd_top_entry *entries, *entry;
+    struct intfd_snapshot *snap;
+    size_t n_entries = 0;
+    size_t sort_idx, i, j;
+    long long int now;
+
+    for (sort_idx = 0; sort_idx < ARRAY_SIZE(cost_windows); sort_idx++) {
+        if (!strcmp(cost_windows[sort_idx].name, window)) {
+            break;
+        }
+    }
+    if (sort_idx == ARRAY_SIZE(cost_windows)) {
+        ds_put_format(ds, "%s: unknown window, use 10s, 1m or 5m", window);
+        return false;
+    }
+
+    snap = intfd_snapshot_get();
+    now = intfd_perf_start();
+    memset(totals, 0, sizeof totals);
+    entries = xmalloc(MAX(snap->n_intfs, 1) * sizeof *entries);
+    for (i = 0; i < snap->n_intfs; i++) {
+        const struct intfd_snapshot_intf *intf = snap->intfs[i];
+
+        if (!intf->cost) {
+            continue;
+        }
+
+        entry = &entries[n_entries];
+        memset(entry->sums, 0, sizeof entry->sums);
+        for (j = 0; j < ARRAY_SIZE(cost_windows); j++) {
+            intfd_cost_window(intf->cost, now, cost_windows[j].n_buckets,
+                              &entry->sums[j]);
+            totals[j].eval_ns += entry->sums[j].eval_ns;
+            totals[j].n_evals += entry->sums[j].n_evals;
+            totals[j].n_writes += entry->sums[j].n_writes;
+        }
+        /* The longest window holds every cost of the others. */
+        if (!entry->sums[ARRAY_SIZE(cost_windows) - 1].n_evals
+            && !entry->sums[ARRAY_SIZE(cost_windows) - 1].n_writes) {
+            continue;
+        }
+        entry->intf = intf;
+        entry->key = entry->sums[sort_idx].eval_ns;
+        n_entries++;
+    }
+    qsort(entries, n_entries, sizeof *entries, intfd_top_compare);
+
+    ds_put_format(ds, "Top %"PRIuSIZE" of %"PRIuSIZE" interfaces with a cost, "
+                  "by evaluation time over %s\n\n",
+                  MIN(n, n_entries), n_entries, window);
+    ds_put_format(ds, "%-16s", "");
+    for (i = 0; i < ARRAY_SIZE(cost_windows); i++) {
+        ds_put_format(ds, "  %26s", cost_windows[i].name);
+    }
+    ds_put_format(ds, "\n%-16s", "Interface");
+    for (i = 0; i < ARRAY_SIZE(cost_windows); i++) {
+        ds_put_format(ds, "  %10s %7s %7s", "eval us", "evals", "writes");
+    }
+    ds_put_cstr(ds, "\n");
+
+    for (j = 0; j < MIN(n, n_entries); j++) {
+        intfd_top_put_sums(ds, entries[j].intf->name, entries[j].sums);
+    }
+    intfd_top_put_sums(ds, "Total", totals);
+    free(entries);
+    intfd_snapshot_unref(snap);
+
+    return true;
+} /* intfd_top_dump */
+
+void
+intfd_set_txn_max_rows(unsigned int max_rows)
+{
+    txn_max_rows = max_rows;
+} /* intfd_set_txn_max_rows */
+
 void
 intfd_wait(void)
 {
     ovsdb_idl_wait(idl);
+    if (arbiter_hold_until) {
+        poll_timer_wait_until(arbiter_hold_until);
+    }
+    if (arbiter_retry_at) {
+        poll_timer_wait_until(arbiter_retry_at);
+    }
 } /* intfd_wait */
 
 /** @} end of group intfd */
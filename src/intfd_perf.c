@@ -0,0 +1,242 @@
+/*
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+/************************************************************************//**
+ * @ingroup ops-intfd
+ *
+ * @file
+ * Latency instrumentation of the ops-intfd main loop.
+ *
+ * Each phase of intfd_run() records its duration into a log-linear
+ * histogram: values below 8 ns have a bucket each, and every power of two
+ * above is split into 8 linear sub-buckets, which bounds the error of a
+ * reported percentile to 12.5%.  Recording is a clz, a shift and an
+ * increment, on the main thread, so nothing is locked.
+ *
+ * The main thread publishes a copy of the statistics through OVS RCU at
+ * the end of each iteration that recorded anything, which is what
+ * intfd_perf_dump() reads, from any thread.  A reset is only requested by
+ * intfd_perf_reset(); the main thread clears its statistics before the
+ * next publication, and copies published before that are dumped as empty.
+ *
+ ***************************************************************************/
+
+#include <string.h>
+
+#include <config.h>
+#include <dynamic-string.h>
+#include <ovs-atomic.h>
+#include <ovs-rcu.h>
+#include <util.h>
+#include <openvswitch/vlog.h>
+
+#include "intfd_perf.h"
+
+VLOG_DEFINE_THIS_MODULE(intfd_perf);
+
+/** @ingroup intfd
+ * @{ */
+
+struct intfd_perf_stats {
+    struct intfd_perf_histogram histograms[INTFD_PERF_N_PHASES];
+    unsigned long long int counters[INTFD_PERF_N_COUNTERS];
+    uint64_t reset_seq;                 /* Last reset applied. */
+};
+
+/* Recorded by the main thread. */
+static struct intfd_perf_stats stats;
+static bool stats_dirty;
+
+/* The copy last published by intfd_perf_publish(). */
+static OVSRCU_TYPE(struct intfd_perf_stats *) published;
+
+/* Resets requested by intfd_perf_reset(). */
+static atomic_uint64_t reset_seq = ATOMIC_VAR_INIT(0);
+
+static const char *phase_names[INTFD_PERF_N_PHASES] = {
+    [INTFD_PERF_IDL_RUN]            = "idl_run",
+    [INTFD_PERF_PORT_RECONFIGURE]   = "port_reconfigure",
+    [INTFD_PERF_CONFIG_MODS]        = "config_mods",
+    [INTFD_PERF_EVALUATE]           = "evaluate",
+    [INTFD_PERF_FLUSH]              = "flush_writes",
+    [INTFD_PERF_ARBITER]            = "arbiter",
+    [INTFD_PERF_SNAPSHOT]           = "snapshot",
+    [INTFD_PERF_COMMIT]             = "commit",
+    [INTFD_PERF_ITERATION]          = "iteration",
+};
+
+static const char *counter_names[INTFD_PERF_N_COUNTERS] = {
+    [INTFD_PERF_ROWS_CHANGED]       = "Rows changed",
+    [INTFD_PERF_ROWS_WRITTEN]       = "Rows written",
+    [INTFD_PERF_COMMITS]            = "Commits",
+};
+
+static inline unsigned int
+intfd_perf_bucket(unsigned long long int value)
+{
+    unsigned int msb;
+
+    if (value < INTFD_PERF_SUB_BUCKETS) {
+        return value;
+    }
+    msb = 63 - raw_clz64(value);
+    return ((msb - INTFD_PERF_SUB_BITS + 1) << INTFD_PERF_SUB_BITS)
+           + ((value >> (msb - INTFD_PERF_SUB_BITS))
+              & (INTFD_PERF_SUB_BUCKETS - 1));
+}
+
+/* Returns the highest value that falls into 'bucket'. */
+static unsigned long long int
+intfd_perf_bucket_max(unsigned int bucket)
+{
+    unsigned int msb, sub;
+
+    if (bucket < INTFD_PERF_SUB_BUCKETS) {
+        return bucket;
+    }
+    msb = (bucket >> INTFD_PERF_SUB_BITS) + INTFD_PERF_SUB_BITS - 1;
+    sub = bucket & (INTFD_PERF_SUB_BUCKETS - 1);
+    return (((unsigned long long int) (INTFD_PERF_SUB_BUCKETS + sub + 1))
+            << (msb - INTFD_PERF_SUB_BITS)) - 1;
+}
+
+/* Returns the value at percentile 'pct' of 'h', rounded up to the upper
+ * bound of its bucket but never above the recorded maximum. */
+unsigned long long int
+intfd_perf_histogram_percentile(const struct intfd_perf_histogram *h,
+                                unsigned int pct)
+{
+    unsigned long long int rank, seen = 0;
+    unsigned int i;
+
+    if (!h->count) {
+        return 0;
+    }
+
+    rank = (h->count * pct + 99) / 100;
+    for (i = 0; i < INTFD_PERF_N_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            return MIN(intfd_perf_bucket_max(i), h->max);
+        }
+    }
+    return h->max;
+} /* intfd_perf_histogram_percentile */
+
+void
+intfd_perf_histogram_record(struct intfd_perf_histogram *h,
+                            unsigned long long int value)
+{
+    h->count++;
+    h->total += value;
+    if (value > h->max) {
+        h->max = value;
+    }
+    h->buckets[intfd_perf_bucket(value)]++;
+} /* intfd_perf_histogram_record */
+
+/* Records that 'phase' ran from 'start', as returned by intfd_perf_start(),
+ * until now. */
+void
+intfd_perf_end(enum intfd_perf_phase phase, long long int start)
+{
+    long long int elapsed = intfd_perf_start() - start;
+
+    intfd_perf_histogram_record(&stats.histograms[phase],
+                                elapsed > 0 ? elapsed : 0);
+    stats_dirty = true;
+} /* intfd_perf_end */
+
+void
+intfd_perf_count(enum intfd_perf_counter counter, unsigned long long int n)
+{
+    stats.counters[counter] += n;
+    stats_dirty = true;
+} /* intfd_perf_count */
+
+/* Publishes a copy of the statistics for intfd_perf_dump(), first clearing
+ * them if a reset was requested.  Main thread only. */
+void
+intfd_perf_publish(void)
+{
+    struct intfd_perf_stats *copy, *old;
+    uint64_t seq;
+
+    atomic_read(&reset_seq, &seq);
+    if (seq != stats.reset_seq) {
+        memset(&stats, 0, sizeof stats);
+        stats.reset_seq = seq;
+        stats_dirty = true;
+    }
+    if (!stats_dirty) {
+        return;
+    }
+
+    copy = xmemdup(&stats, sizeof stats);
+    old = ovsrcu_get_protected(struct intfd_perf_stats *, &published);
+    ovsrcu_set(&published, copy);
+    if (old) {
+        ovsrcu_postpone(free, old);
+    }
+    stats_dirty = false;
+} /* intfd_perf_publish */
+
+/* Requests that the statistics be cleared.  May be called from any
+ * thread. */
+void
+intfd_perf_reset(void)
+{
+    uint64_t orig;
+
+    atomic_add(&reset_seq, 1, &orig);
+} /* intfd_perf_reset */
+
+/* Appends the statistics last published to 'ds'.  May be called from any
+ * thread. */
+void
+intfd_perf_dump(struct ds *ds)
+{
+    static const struct intfd_perf_stats empty;
+    const struct intfd_perf_stats *s;
+    uint64_t seq;
+    int i;
+
+    s = ovsrcu_get(struct intfd_perf_stats *, &published);
+    atomic_read(&reset_seq, &seq);
+    if (!s || s->reset_seq != seq) {
+        s = &empty;
+    }
+
+    ds_put_format(ds, "%-18s %10s %10s %10s %10s %10s\n", "Phase (us)",
+                  "count", "mean", "p50", "p99", "max");
+    for (i = 0; i < INTFD_PERF_N_PHASES; i++) {
+        const struct intfd_perf_histogram *h = &s->histograms[i];
+
+        ds_put_format(ds, "%-18s %10llu %10.1f %10.1f %10.1f %10.1f\n",
+                      phase_names[i], h->count,
+                      h->count ? h->total / 1000.0 / h->count : 0.0,
+                      intfd_perf_histogram_percentile(h, 50) / 1000.0,
+                      intfd_perf_histogram_percentile(h, 99) / 1000.0,
+                      h->max / 1000.0);
+    }
+
+    ds_put_cstr(ds, "\n");
+    for (i = 0; i < INTFD_PERF_N_COUNTERS; i++) {
+        ds_put_format(ds, "%-18s %10llu\n", counter_names[i],
+                      s->counters[i]);
+    }
+} /* intfd_perf_dump */
+
+/** @} end of group intfd */
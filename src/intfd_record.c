@@ -0,0 +1,309 @@
+/*
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+/************************************************************************//**
+ * @ingroup ops-intfd
+ *
+ * @file
+ * Recorder of the OVSDB changes processed by ops-intfd.
+ *
+ * Every time the IDL has changed, the rows of the tables ops-intfd reads
+ * are compared with the ones recorded so far, and one line describing the
+ * batch is appended to the record file:
+ *
+ *   {"msec":120,"ops":[{"op":"update","table":"Interface",
+ *                       "uuid":"...","row":{"user_config":[...]}}, ...]}
+ *
+ * "msec" is the time since the recording started.  Each op is an "insert"
+ * with all the recorded columns of a row, an "update" with only the
+ * columns that changed or a "delete".  The first batch inserts every
+ * existing row.  Only the columns ops-intfd reads are recorded; its own
+ * writes are not.  The first line of the file is a header with the wall
+ * clock time at which the recording started.
+ *
+ * A column is known to have changed when the hash of its datum differs
+ * from the recorded one, so recording costs a pass over the rows of every
+ * batch.  utilities/ops-intfd-replay replays a record file.
+ *
+ ***************************************************************************/
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <config.h>
+#include <dynamic-string.h>
+#include <hash.h>
+#include <hmap.h>
+#include <json.h>
+#include <ovsdb-data.h>
+#include <ovsdb-idl.h>
+#include <ovsdb-idl-provider.h>
+#include <timeval.h>
+#include <util.h>
+#include <uuid.h>
+#include <openvswitch/vlog.h>
+#include <vswitch-idl.h>
+
+#include "intfd_record.h"
+
+VLOG_DEFINE_THIS_MODULE(intfd_record);
+
+/** @ingroup intfd
+ * @{ */
+
+#define INTFD_RECORD_MAX_COLUMNS    16
+
+/* A table ops-intfd reads, and the columns of it that are recorded. */
+struct intfd_record_table {
+    const struct ovsdb_idl_table_class *class;
+    const struct ovsdb_idl_column *columns[INTFD_RECORD_MAX_COLUMNS];
+    size_t n_columns;
+};
+
+/* The inputs monitored by intfd_ovsdb_init(). */
+static const struct intfd_record_table intfd_record_tables[] = {
+    {&ovsrec_table_system,
+     {&ovsrec_system_col_cur_cfg}, 1},
+    {&ovsrec_table_subsystem,
+     {&ovsrec_subsystem_col_name,
+      &ovsrec_subsystem_col_other_info}, 2},
+    {&ovsrec_table_port,
+     {&ovsrec_port_col_name,
+      &ovsrec_port_col_admin,
+      &ovsrec_port_col_interfaces}, 3},
+    {&ovsrec_table_interface,
+     {&ovsrec_interface_col_name,
+      &ovsrec_interface_col_type,
+      &ovsrec_interface_col_user_config,
+      &ovsrec_interface_col_hw_intf_info,
+      &ovsrec_interface_col_pm_info,
+      &ovsrec_interface_col_split_parent,
+      &ovsrec_interface_col_split_children,
+      &ovsrec_interface_col_bond_status,
+      &ovsrec_interface_col_hw_status}, 9},
+};
+
+/* A recorded row, with the hash of each of its recorded columns. */
+struct intfd_record_row {
+    struct hmap_node node;          /* In 'rows', by UUID. */
+    struct uuid uuid;
+    const struct intfd_record_table *table;
+    unsigned int batch;             /* Last batch the row was seen in. */
+    uint32_t hashes[INTFD_RECORD_MAX_COLUMNS];
+};
+
+static FILE *record_file;
+static char *record_file_name;
+static struct hmap rows = HMAP_INITIALIZER(&rows);
+static unsigned int batch;
+static unsigned int record_seqno;
+static long long int record_start;
+
+static struct intfd_record_row *
+intfd_record_find(const struct uuid *uuid)
+{
+    struct intfd_record_row *row;
+
+    HMAP_FOR_EACH_WITH_HASH (row, node, uuid_hash(uuid), &rows) {
+        if (uuid_equals(&row->uuid, uuid)) {
+            return row;
+        }
+    }
+    return NULL;
+} /* intfd_record_find */
+
+static struct json *
+intfd_record_op(const char *op, const struct intfd_record_table *table,
+                const struct uuid *uuid)
+{
+    struct json *json = json_object_create();
+
+    json_object_put_string(json, "op", op);
+    json_object_put_string(json, "table", table->class->name);
+    json_object_put(json, "uuid",
+                    json_string_create_nocopy(
+                        xasprintf(UUID_FMT, UUID_ARGS(uuid))));
+    return json;
+} /* intfd_record_op */
+
+/* Appends to 'ops' the insert or update of 'idl_row', if any of its
+ * recorded columns changed. */
+static void
+intfd_record_row(const struct intfd_record_table *table,
+                 const struct ovsdb_idl_row *idl_row, struct json *ops)
+{
+    const struct ovsdb_idl_column *column;
+    const struct ovsdb_datum *datum;
+    struct intfd_record_row *row;
+    struct json *columns = NULL;
+    struct json *op;
+    bool inserted = false;
+    uint32_t hash;
+    size_t i;
+
+    row = intfd_record_find(&idl_row->uuid);
+    if (!row) {
+        row = xzalloc(sizeof *row);
+        row->uuid = idl_row->uuid;
+        row->table = table;
+        hmap_insert(&rows, &row->node, uuid_hash(&row->uuid));
+        inserted = true;
+    }
+    row->batch = batch;
+
+    for (i = 0; i < table->n_columns; i++) {
+        column = table->columns[i];
+        datum = ovsdb_idl_read(idl_row, column);
+        hash = ovsdb_datum_hash(datum, &column->type, 0);
+        if (!inserted && hash == row->hashes[i]) {
+            continue;
+        }
+
+        row->hashes[i] = hash;
+        if (!columns) {
+            columns = json_object_create();
+        }
+        json_object_put(columns, column->name,
+                        ovsdb_datum_to_json(datum, &column->type));
+    }
+
+    if (columns) {
+        op = intfd_record_op(inserted ? "insert" : "update", table,
+                             &row->uuid);
+        json_object_put(op, "row", columns);
+        json_array_add(ops, op);
+    }
+} /* intfd_record_row */
+
+static void
+intfd_record_clear(void)
+{
+    struct intfd_record_row *row, *next;
+
+    HMAP_FOR_EACH_SAFE (row, next, node, &rows) {
+        hmap_remove(&rows, &row->node);
+        free(row);
+    }
+} /* intfd_record_clear */
+
+/* Starts recording into 'file_name', which is truncated.  Returns false
+ * and sets '*errorp' to a malloc()'d message on failure. */
+bool
+intfd_record_start(const char *file_name, char **errorp)
+{
+    FILE *file;
+
+    file = fopen(file_name, "w");
+    if (!file) {
+        *errorp = xasprintf("%s: open failed (%s)", file_name,
+                            ovs_strerror(errno));
+        return false;
+    }
+
+    intfd_record_stop();
+    record_file = file;
+    record_file_name = xstrdup(file_name);
+    record_start = time_msec();
+    record_seqno = 0;
+    fprintf(record_file, "{\"version\":1,\"start\":%lld}\n",
+            time_wall_msec());
+    VLOG_INFO("Recording OVSDB changes into %s", file_name);
+
+    return true;
+} /* intfd_record_start */
+
+void
+intfd_record_stop(void)
+{
+    if (record_file) {
+        fclose(record_file);
+        VLOG_INFO("Stopped recording OVSDB changes into %s",
+                  record_file_name);
+        record_file = NULL;
+    }
+    free(record_file_name);
+    record_file_name = NULL;
+    intfd_record_clear();
+} /* intfd_record_stop */
+
+/* Returns the name of the record file, NULL if not recording. */
+const char *
+intfd_record_file_name(void)
+{
+    return record_file_name;
+} /* intfd_record_file_name */
+
+/* Records the changes of 'idl' since the last call, if recording. */
+void
+intfd_record_run(const struct ovsdb_idl *idl)
+{
+    const struct intfd_record_table *table;
+    const struct ovsdb_idl_row *idl_row;
+    struct intfd_record_row *row, *next;
+    struct json *ops, *json;
+    struct ds ds;
+    size_t i;
+
+    if (!record_file || ovsdb_idl_get_seqno(idl) == record_seqno) {
+        return;
+    }
+    record_seqno = ovsdb_idl_get_seqno(idl);
+    batch++;
+
+    ops = json_array_create_empty();
+    for (i = 0; i < ARRAY_SIZE(intfd_record_tables); i++) {
+        table = &intfd_record_tables[i];
+        for (idl_row = ovsdb_idl_first_row(idl, table->class); idl_row;
+             idl_row = ovsdb_idl_next_row(idl_row)) {
+            intfd_record_row(table, idl_row, ops);
+        }
+    }
+
+    HMAP_FOR_EACH_SAFE (row, next, node, &rows) {
+        if (row->batch != batch) {
+            json_array_add(ops, intfd_record_op("delete", row->table,
+                                                &row->uuid));
+            hmap_remove(&rows, &row->node);
+            free(row);
+        }
+    }
+
+    if (!json_array(ops)->n) {
+        json_destroy(ops);
+        return;
+    }
+
+    json = json_object_create();
+    json_object_put(json, "msec",
+                    json_integer_create(time_msec() - record_start));
+    json_object_put(json, "ops", ops);
+
+    ds_init(&ds);
+    json_to_ds(json, 0, &ds);
+    ds_put_char(&ds, '\n');
+    json_destroy(json);
+
+    /* Flushed, so that the record is usable even if ops-intfd crashes. */
+    if (fwrite(ds_cstr(&ds), ds.length, 1, record_file) != 1
+        || fflush(record_file)) {
+        VLOG_ERR("%s: write failed (%s)", record_file_name,
+                 ovs_strerror(errno));
+        intfd_record_stop();
+    }
+    ds_destroy(&ds);
+} /* intfd_record_run */
+
+/** @} end of group intfd */
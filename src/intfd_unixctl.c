@@ -0,0 +1,305 @@
+/*
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+/************************************************************************//**
+ * @ingroup intfd
+ *
+ * @file
+ * Source for the ovs-appctl service thread of ops-intfd.
+ *
+ * The unixctl server of ops-intfd runs on a thread of its own, so that
+ * ovs-appctl keeps answering while the main loop is busy with a long
+ * reconfiguration or a blocking commit, and so that building a large reply
+ * does not delay the processing of OVSDB changes.  The commands that only
+ * read the published state snapshot, or state that is otherwise thread
+ * safe, are registered with unixctl_command_register() and run on the
+ * service thread.
+ *
+ * The commands that read or change the state owned by the main thread are
+ * registered with intfd_unixctl_register_main().  The service thread
+ * queues each of their requests for the main thread, which runs them from
+ * intfd_unixctl_run() and queues the replies back.  The service thread
+ * owns the connections, so it sends every reply itself.
+ *
+ ***************************************************************************/
+
+#include <pthread.h>
+#include <string.h>
+
+#include <config.h>
+#include <dynamic-string.h>
+#include <ovs-atomic.h>
+#include <ovs-thread.h>
+#include <poll-loop.h>
+#include <seq.h>
+#include <unixctl.h>
+#include <util.h>
+
+#include "intfd_unixctl.h"
+
+/** @ingroup intfd
+ * @{ */
+
+/* A command run by the main thread. */
+struct intfd_unixctl_command {
+    intfd_unixctl_main_cb *cb;
+    void *aux;
+};
+
+/* A request for a command run by the main thread, and its reply. */
+struct intfd_unixctl_request {
+    struct unixctl_conn *conn;
+    const struct intfd_unixctl_command *command;
+    int argc;
+    char **argv;
+    struct ds reply;
+    bool ok;
+};
+
+struct intfd_unixctl_queue {
+    struct intfd_unixctl_request **requests;
+    size_t n, allocated;
+};
+
+static struct ovs_mutex mutex = OVS_MUTEX_INITIALIZER;
+static struct intfd_unixctl_queue requests;
+static struct intfd_unixctl_queue replies;
+
+static struct seq *request_seq;     /* Changed when a request is queued. */
+static struct seq *reply_seq;       /* Changed when replies are queued, and
+                                     * on exit. */
+static uint64_t request_seqno;      /* Main thread only. */
+
+static struct unixctl_server *server;
+static atomic_bool exiting;
+static pthread_t service;
+static bool service_running;
+
+static void
+intfd_unixctl_push(struct intfd_unixctl_queue *queue,
+                   struct intfd_unixctl_request *request)
+{
+    if (queue->n >= queue->allocated) {
+        queue->requests = x2nrealloc(queue->requests, &queue->allocated,
+                                     sizeof *queue->requests);
+    }
+    queue->requests[queue->n++] = request;
+} /* intfd_unixctl_push */
+
+/* Moves the content of 'queue' into 'taken', which must be empty. */
+static void
+intfd_unixctl_take(struct intfd_unixctl_queue *queue,
+                   struct intfd_unixctl_queue *taken)
+{
+    ovs_mutex_lock(&mutex);
+    *taken = *queue;
+    memset(queue, 0, sizeof *queue);
+    ovs_mutex_unlock(&mutex);
+} /* intfd_unixctl_take */
+
+static void
+intfd_unixctl_request_destroy(struct intfd_unixctl_request *request)
+{
+    int i;
+
+    for (i = 0; i < request->argc; i++) {
+        free(request->argv[i]);
+    }
+    free(request->argv);
+    ds_destroy(&request->reply);
+    free(request);
+} /* intfd_unixctl_request_destroy */
+
+/* unixctl callback of the commands registered with
+ * intfd_unixctl_register_main(), run by the service thread. */
+static void
+intfd_unixctl_forward(struct unixctl_conn *conn, int argc, const char *argv[],
+                      void *command_)
+{
+    struct intfd_unixctl_request *request = xzalloc(sizeof *request);
+    int i;
+
+    request->conn = conn;
+    request->command = command_;
+    request->argc = argc;
+    request->argv = xmalloc(argc * sizeof *request->argv);
+    for (i = 0; i < argc; i++) {
+        request->argv[i] = xstrdup(argv[i]);
+    }
+    ds_init(&request->reply);
+
+    ovs_mutex_lock(&mutex);
+    intfd_unixctl_push(&requests, request);
+    ovs_mutex_unlock(&mutex);
+    seq_change(request_seq);
+} /* intfd_unixctl_forward */
+
+/* Sends the replies the main thread queued.  Must be called by the thread
+ * that runs the unixctl server. */
+static void
+intfd_unixctl_send_replies(void)
+{
+    struct intfd_unixctl_queue taken;
+    struct intfd_unixctl_request *request;
+    size_t i;
+
+    intfd_unixctl_take(&replies, &taken);
+    for (i = 0; i < taken.n; i++) {
+        request = taken.requests[i];
+        if (request->ok) {
+            unixctl_command_reply(request->conn, ds_cstr(&request->reply));
+        } else {
+            unixctl_command_reply_error(request->conn,
+                                        ds_cstr(&request->reply));
+        }
+        intfd_unixctl_request_destroy(request);
+    }
+    free(taken.requests);
+} /* intfd_unixctl_send_replies */
+
+static void *
+intfd_unixctl_main(void *arg OVS_UNUSED)
+{
+    uint64_t seqno;
+    bool stop;
+
+    for (;;) {
+        /* Read before taking the replies, so that a reply queued right
+         * after wakes us up. */
+        seqno = seq_read(reply_seq);
+        atomic_read_relaxed(&exiting, &stop);
+
+        unixctl_server_run(server);
+        intfd_unixctl_send_replies();
+        if (stop) {
+            break;
+        }
+
+        unixctl_server_wait(server);
+        seq_wait(reply_seq, seqno);
+        poll_block();
+    }
+
+    return NULL;
+} /* intfd_unixctl_main */
+
+/* Registers an ovs-appctl command, like unixctl_command_register(), whose
+ * callback 'cb' is run by the main thread from intfd_unixctl_run().  Must
+ * be called before intfd_unixctl_start(). */
+void
+intfd_unixctl_register_main(const char *name, const char *usage,
+                            int min_args, int max_args,
+                            intfd_unixctl_main_cb *cb, void *aux)
+{
+    /* Never freed, like the unixctl commands themselves. */
+    struct intfd_unixctl_command *command = xmalloc(sizeof *command);
+
+    command->cb = cb;
+    command->aux = aux;
+    unixctl_command_register(name, usage, min_args, max_args,
+                             intfd_unixctl_forward, command);
+} /* intfd_unixctl_register_main */
+
+/* Starts the service thread, which runs 'server' from now on.  Every
+ * command must be registered by then. */
+void
+intfd_unixctl_start(struct unixctl_server *server_)
+{
+    server = server_;
+    request_seq = seq_create();
+    reply_seq = seq_create();
+    request_seqno = seq_read(request_seq);
+    atomic_init(&exiting, false);
+    service = ovs_thread_create("intfd_unixctl", intfd_unixctl_main, NULL);
+    service_running = true;
+} /* intfd_unixctl_start */
+
+/* Stops the service thread once it has sent the queued replies.  The
+ * requests the main thread did not run are answered with an error.  The
+ * server then belongs to the caller again. */
+void
+intfd_unixctl_stop(void)
+{
+    struct intfd_unixctl_queue taken;
+    size_t i;
+
+    if (!service_running) {
+        return;
+    }
+
+    atomic_store_relaxed(&exiting, true);
+    seq_change(reply_seq);
+    xpthread_join(service, NULL);
+    service_running = false;
+
+    intfd_unixctl_take(&requests, &taken);
+    for (i = 0; i < taken.n; i++) {
+        unixctl_command_reply_error(taken.requests[i]->conn, "exiting");
+        intfd_unixctl_request_destroy(taken.requests[i]);
+    }
+    free(taken.requests);
+    intfd_unixctl_send_replies();
+
+    seq_destroy(request_seq);
+    seq_destroy(reply_seq);
+    request_seq = reply_seq = NULL;
+    server = NULL;
+} /* intfd_unixctl_stop */
+
+/* Runs the commands the service thread queued for the main thread. */
+void
+intfd_unixctl_run(void)
+{
+    struct intfd_unixctl_queue taken;
+    struct intfd_unixctl_request *request;
+    const struct intfd_unixctl_command *command;
+    size_t i;
+
+    if (!service_running) {
+        return;
+    }
+
+    request_seqno = seq_read(request_seq);
+    intfd_unixctl_take(&requests, &taken);
+    if (!taken.n) {
+        return;
+    }
+
+    for (i = 0; i < taken.n; i++) {
+        request = taken.requests[i];
+        command = request->command;
+        request->ok = command->cb(request->argc,
+                                  (const char **) request->argv,
+                                  command->aux, &request->reply);
+    }
+
+    ovs_mutex_lock(&mutex);
+    for (i = 0; i < taken.n; i++) {
+        intfd_unixctl_push(&replies, taken.requests[i]);
+    }
+    ovs_mutex_unlock(&mutex);
+    free(taken.requests);
+    seq_change(reply_seq);
+} /* intfd_unixctl_run */
+
+void
+intfd_unixctl_wait(void)
+{
+    if (service_running) {
+        seq_wait(request_seq, request_seqno);
+    }
+} /* intfd_unixctl_wait */
+
+/** @} end of group intfd */
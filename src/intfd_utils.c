@@ -37,6 +37,10 @@ intfd_print_smap(const char *name, const struct smap *map)
 {
     struct smap_node *node;
 
+    if (!VLOG_IS_DBG_ENABLED()) {
+        return;
+    }
+
     VLOG_DBG("intfd - %s", name);
 
     SMAP_FOR_EACH(node, map) {
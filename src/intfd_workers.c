@@ -0,0 +1,198 @@
+/*
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+/************************************************************************//**
+ * @ingroup intfd
+ *
+ * @file
+ * Source for the ops-intfd evaluation worker pool.
+ *
+ * The pool runs a function over an array of items using the main thread
+ * and a fixed set of worker threads.  Threads claim chunks of the array
+ * through a shared atomic cursor, so faster threads simply take more
+ * chunks.  intfd_workers_run() returns once every item has been handled;
+ * nothing the workers touch is shared with OVSDB.
+ *
+ ***************************************************************************/
+
+#include <pthread.h>
+
+#include <config.h>
+#include <ovs-atomic.h>
+#include <ovs-thread.h>
+#include <util.h>
+#include <openvswitch/vlog.h>
+
+#include "intfd_workers.h"
+
+VLOG_DEFINE_THIS_MODULE(intfd_workers);
+
+/** @ingroup intfd
+ * @{ */
+
+/* Number of items a thread claims at a time. */
+#define INTFD_WORKERS_CHUNK     32
+
+static struct {
+    struct ovs_mutex mutex;
+    pthread_cond_t work_cond;       /* A batch was posted or exiting. */
+    pthread_cond_t done_cond;       /* The last worker finished a batch. */
+    pthread_t *threads;
+    unsigned int n_threads;         /* Worker threads, main not included. */
+
+    /* The current batch, posted under 'mutex'. */
+    uint64_t batch_seq;
+    unsigned int n_busy;
+    bool exiting;
+    void (*fn)(void *item);
+    void **items;
+    size_t n_items;
+    atomic_uint next;               /* First item not yet claimed. */
+} workers = {
+    .mutex = OVS_MUTEX_INITIALIZER,
+};
+
+static void
+intfd_workers_drain(void)
+{
+    unsigned int start;
+    size_t i, end;
+
+    for (;;) {
+        atomic_add(&workers.next, INTFD_WORKERS_CHUNK, &start);
+        if (start >= workers.n_items) {
+            break;
+        }
+
+        end = MIN(start + INTFD_WORKERS_CHUNK, workers.n_items);
+        for (i = start; i < end; i++) {
+            if (workers.items[i]) {
+                workers.fn(workers.items[i]);
+            }
+        }
+    }
+} /* intfd_workers_drain */
+
+static void *
+intfd_worker_main(void *arg OVS_UNUSED)
+{
+    /* Workers are only started with no batch posted, see
+     * intfd_workers_exit(). */
+    uint64_t seen = 0;
+
+    for (;;) {
+        ovs_mutex_lock(&workers.mutex);
+        while (workers.batch_seq == seen && !workers.exiting) {
+            ovs_mutex_cond_wait(&workers.work_cond, &workers.mutex);
+        }
+        if (workers.exiting) {
+            ovs_mutex_unlock(&workers.mutex);
+            break;
+        }
+        seen = workers.batch_seq;
+        ovs_mutex_unlock(&workers.mutex);
+
+        intfd_workers_drain();
+
+        ovs_mutex_lock(&workers.mutex);
+        if (!--workers.n_busy) {
+            xpthread_cond_signal(&workers.done_cond);
+        }
+        ovs_mutex_unlock(&workers.mutex);
+    }
+
+    return NULL;
+} /* intfd_worker_main */
+
+/* Starts the pool with 'n_threads' evaluating threads in total, including
+ * the main thread.  0 or 1 keeps all evaluation on the main thread. */
+void
+intfd_workers_init(unsigned int n_threads)
+{
+    unsigned int i;
+
+    xpthread_cond_init(&workers.work_cond, NULL);
+    xpthread_cond_init(&workers.done_cond, NULL);
+    atomic_init(&workers.next, 0);
+    workers.exiting = false;
+
+    workers.n_threads = n_threads > 1 ? n_threads - 1 : 0;
+    if (!workers.n_threads) {
+        return;
+    }
+
+    workers.threads = xmalloc(workers.n_threads * sizeof *workers.threads);
+    for (i = 0; i < workers.n_threads; i++) {
+        workers.threads[i] = ovs_thread_create("intfd_eval",
+                                               intfd_worker_main, NULL);
+    }
+    VLOG_INFO("Started %u interface evaluation threads", workers.n_threads);
+} /* intfd_workers_init */
+
+void
+intfd_workers_exit(void)
+{
+    unsigned int i;
+
+    ovs_mutex_lock(&workers.mutex);
+    workers.exiting = true;
+    xpthread_cond_broadcast(&workers.work_cond);
+    ovs_mutex_unlock(&workers.mutex);
+
+    for (i = 0; i < workers.n_threads; i++) {
+        xpthread_join(workers.threads[i], NULL);
+    }
+    free(workers.threads);
+    workers.threads = NULL;
+    workers.n_threads = 0;
+
+    /* A pool started again must not take the last batch for a new one. */
+    workers.batch_seq = 0;
+    workers.n_busy = 0;
+} /* intfd_workers_exit */
+
+/* Returns the number of worker threads, the main thread not included. */
+unsigned int
+intfd_workers_count(void)
+{
+    return workers.n_threads;
+} /* intfd_workers_count */
+
+/* Calls 'fn' once for every non-NULL entry of 'items', spread over the
+ * main thread and the workers.  Each item is handled by exactly one
+ * thread, in no particular order. */
+void
+intfd_workers_run(void (*fn)(void *item), void **items, size_t n_items)
+{
+    ovs_mutex_lock(&workers.mutex);
+    workers.fn = fn;
+    workers.items = items;
+    workers.n_items = n_items;
+    atomic_store(&workers.next, 0);
+    workers.n_busy = workers.n_threads;
+    workers.batch_seq++;
+    xpthread_cond_broadcast(&workers.work_cond);
+    ovs_mutex_unlock(&workers.mutex);
+
+    intfd_workers_drain();
+
+    ovs_mutex_lock(&workers.mutex);
+    while (workers.n_busy) {
+        ovs_mutex_cond_wait(&workers.done_cond, &workers.mutex);
+    }
+    ovs_mutex_unlock(&workers.mutex);
+} /* intfd_workers_run */
+
+/** @} end of group intfd */
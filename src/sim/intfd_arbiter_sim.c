@@ -0,0 +1,326 @@
+/*
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+/************************************************************************//**
+ * @ingroup ops-intfd
+ *
+ * @file
+ * Simulator for the interface arbiter of ops-intfd.
+ *
+ * Runs intfd_arbiter.c against synthetic Interface rows, without an IDL or
+ * ovsdb-server.  Random bond_status and hw_intf_config changes are applied
+ * to N interfaces, and each changed interface is run through the arbiter
+ * the same way intfd_arbiter_run() does.  At the end, the forwarding_state
+ * of every row is checked against a reference model of the arbiter.
+ *
+ * Reports the evaluations per second and the heap allocations per
+ * evaluation, and exits with status 1 if any row differs from the model.
+ *
+ ***************************************************************************/
+
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <config.h>
+#include <command-line.h>
+#include <random.h>
+#include <smap.h>
+#include <util.h>
+#include <openvswitch/vlog.h>
+#include <vswitch-idl.h>
+#include <openswitch-idl.h>
+
+#include "intfd.h"
+#include "sim_alloc.h"
+
+VLOG_DEFINE_THIS_MODULE(intfd_arbiter_sim);
+
+#define SIM_DEFAULT_INTERFACES   1024
+#define SIM_DEFAULT_STEPS        1000000
+
+/* A synthetic Interface row and the arbiter state intfd keeps for it. */
+struct sim_iface {
+    struct ovsrec_interface row;
+    struct intfd_arbiter_state arbiter;
+};
+
+static unsigned long long n_key_writes;
+
+/* The arbiter writes forwarding_state through partial map updates of the
+ * IDL.  Apply them directly to the synthetic row instead. */
+void
+ovsrec_interface_update_forwarding_state_setkey(
+    const struct ovsrec_interface *row, const char *key, const char *value)
+{
+    struct ovsrec_interface *ifrow = CONST_CAST(struct ovsrec_interface *, row);
+
+    smap_replace(&ifrow->forwarding_state, key, value);
+    n_key_writes++;
+}
+
+void
+ovsrec_interface_update_forwarding_state_delkey(
+    const struct ovsrec_interface *row, const char *key)
+{
+    struct ovsrec_interface *ifrow = CONST_CAST(struct ovsrec_interface *, row);
+
+    smap_remove(&ifrow->forwarding_state, key);
+    n_key_writes++;
+}
+
+/* Reference model of the arbiter with its single 'aggregation' layer and
+ * no hysteresis: the layer is absent when the interface is down, blocked
+ * by LACP when the bond is not up, and forwarding otherwise. */
+static void
+sim_reference_state(const struct ovsrec_interface *ifrow,
+                    struct smap *forwarding_state)
+{
+    const char *enable, *bond_state;
+
+    enable = smap_get(&ifrow->hw_intf_config,
+                      INTERFACE_HW_INTF_CONFIG_MAP_ENABLE);
+    bond_state = smap_get(&ifrow->bond_status,
+                          INTERFACE_BOND_STATUS_MAP_STATE);
+
+    smap_init(forwarding_state);
+    if (!enable || strcmp(enable, INTERFACE_HW_INTF_CONFIG_MAP_ENABLE_TRUE)) {
+        smap_add(forwarding_state, INTERFACE_FORWARDING_STATE_MAP_FORWARDING,
+                 INTERFACE_FORWARDING_STATE_FORWARDING_FALSE);
+    } else if (bond_state && strcmp(bond_state, INTERFACE_BOND_STATUS_UP)) {
+        smap_add(forwarding_state,
+                 INTERFACE_FORWARDING_STATE_MAP_INTERFACE_AGGREGATION_FORWARDING,
+                 INTERFACE_FORWARDING_STATE_FORWARDING_FALSE);
+        smap_add(forwarding_state,
+                 INTERFACE_FORWARDING_STATE_MAP_INTERFACE_AGGREGATION_BLOCKED_REASON,
+                 INTERFACE_FORWARDING_STATE_PROTOCOL_LACP);
+        smap_add(forwarding_state, INTERFACE_FORWARDING_STATE_MAP_FORWARDING,
+                 INTERFACE_FORWARDING_STATE_FORWARDING_FALSE);
+    } else {
+        smap_add(forwarding_state,
+                 INTERFACE_FORWARDING_STATE_MAP_INTERFACE_AGGREGATION_FORWARDING,
+                 INTERFACE_FORWARDING_STATE_FORWARDING_TRUE);
+        smap_add(forwarding_state, INTERFACE_FORWARDING_STATE_MAP_FORWARDING,
+                 INTERFACE_FORWARDING_STATE_FORWARDING_TRUE);
+    }
+} /* sim_reference_state */
+
+/* Applies one random input change to 'ifrow'. */
+static void
+sim_mutate(struct ovsrec_interface *ifrow)
+{
+    switch (random_range(5)) {
+    case 0:
+        smap_replace(&ifrow->bond_status, INTERFACE_BOND_STATUS_MAP_STATE,
+                     INTERFACE_BOND_STATUS_UP);
+        break;
+    case 1:
+        smap_replace(&ifrow->bond_status, INTERFACE_BOND_STATUS_MAP_STATE,
+                     "blocked");
+        break;
+    case 2:
+        smap_remove(&ifrow->bond_status, INTERFACE_BOND_STATUS_MAP_STATE);
+        break;
+    case 3:
+        smap_replace(&ifrow->hw_intf_config,
+                     INTERFACE_HW_INTF_CONFIG_MAP_ENABLE,
+                     INTERFACE_HW_INTF_CONFIG_MAP_ENABLE_TRUE);
+        break;
+    default:
+        smap_replace(&ifrow->hw_intf_config,
+                     INTERFACE_HW_INTF_CONFIG_MAP_ENABLE, "false");
+        break;
+    }
+} /* sim_mutate */
+
+static long long int
+sim_nsec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+} /* sim_nsec */
+
+static void
+usage(void)
+{
+    printf("%s: simulator for the ops-intfd interface arbiter\n"
+           "usage: %s [OPTIONS]\n"
+           "\nOptions:\n"
+           "  --interfaces=N          number of interfaces (default: %d)\n"
+           "  --steps=N               number of input changes (default: %d)\n"
+           "  --seed=N                seed of the random changes\n"
+           "  -h, --help              display this help message\n",
+           program_name, program_name, SIM_DEFAULT_INTERFACES,
+           SIM_DEFAULT_STEPS);
+    exit(EXIT_SUCCESS);
+} /* usage */
+
+int
+main(int argc, char *argv[])
+{
+    enum {
+        OPT_INTERFACES = UCHAR_MAX + 1,
+        OPT_STEPS,
+        OPT_SEED,
+    };
+    static const struct option long_options[] = {
+        {"help",        no_argument, NULL, 'h'},
+        {"interfaces",  required_argument, NULL, OPT_INTERFACES},
+        {"steps",       required_argument, NULL, OPT_STEPS},
+        {"seed",        required_argument, NULL, OPT_SEED},
+        {NULL, 0, NULL, 0},
+    };
+    char *short_options;
+    unsigned int n_ifaces = SIM_DEFAULT_INTERFACES;
+    unsigned int n_steps = SIM_DEFAULT_STEPS;
+    unsigned int seed = 0;
+    unsigned long long n_evals = 0, n_runs = 0;
+    long long int start, elapsed;
+    struct sim_iface *ifaces;
+    size_t n_mismatch = 0;
+    unsigned int i;
+
+    set_program_name(argv[0]);
+
+    short_options = long_options_to_short_options(long_options);
+    for (;;) {
+        int c = getopt_long(argc, argv, short_options, long_options, NULL);
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+        case 'h':
+            usage();
+
+        case OPT_INTERFACES:
+            if (!str_to_uint(optarg, 10, &n_ifaces) || !n_ifaces) {
+                ovs_fatal(0, "--interfaces argument must be a positive "
+                          "integer");
+            }
+            break;
+
+        case OPT_STEPS:
+            if (!str_to_uint(optarg, 10, &n_steps)) {
+                ovs_fatal(0, "--steps argument must be a non-negative "
+                          "integer");
+            }
+            break;
+
+        case OPT_SEED:
+            if (!str_to_uint(optarg, 10, &seed)) {
+                ovs_fatal(0, "--seed argument must be a non-negative "
+                          "integer");
+            }
+            break;
+
+        case '?':
+            exit(EXIT_FAILURE);
+
+        default:
+            abort();
+        }
+    }
+    free(short_options);
+
+    if (seed) {
+        random_set_seed(seed);
+    }
+    intfd_arbiter_init();
+
+    /* Start with every interface up and out of any bond, i.e. the state of
+     * a freshly configured switch. */
+    ifaces = xcalloc(n_ifaces, sizeof *ifaces);
+    for (i = 0; i < n_ifaces; i++) {
+        struct ovsrec_interface *ifrow = &ifaces[i].row;
+
+        ifrow->name = xasprintf("%u", i + 1);
+        smap_init(&ifrow->hw_intf_config);
+        smap_init(&ifrow->bond_status);
+        smap_init(&ifrow->forwarding_state);
+        smap_init(&ifrow->hw_status);
+        smap_add(&ifrow->hw_intf_config, INTERFACE_HW_INTF_CONFIG_MAP_ENABLE,
+                 INTERFACE_HW_INTF_CONFIG_MAP_ENABLE_TRUE);
+    }
+
+    start = sim_nsec();
+    for (i = 0; i < n_ifaces + n_steps; i++) {
+        struct sim_iface *iface;
+
+        /* Evaluate every interface once, then apply the random changes. */
+        if (i < n_ifaces) {
+            iface = &ifaces[i];
+        } else {
+            iface = &ifaces[random_range(n_ifaces)];
+            sim_mutate(&iface->row);
+        }
+
+        sim_alloc_count(true);
+        n_evals++;
+        if (intfd_arbiter_update_inputs(&iface->row, &iface->arbiter, 0)) {
+            n_runs++;
+            intfd_arbiter_interface_run(&iface->row, &iface->arbiter, 0);
+        }
+        sim_alloc_count(false);
+    }
+    elapsed = sim_nsec() - start;
+
+    for (i = 0; i < n_ifaces; i++) {
+        const struct ovsrec_interface *ifrow = &ifaces[i].row;
+        struct smap expected;
+
+        sim_reference_state(ifrow, &expected);
+        if (!smap_equal(&expected, &ifrow->forwarding_state)) {
+            if (!n_mismatch) {
+                fprintf(stderr, "interface %s: forwarding_state differs from "
+                        "the reference model\n", ifrow->name);
+            }
+            n_mismatch++;
+        }
+        smap_destroy(&expected);
+    }
+
+    printf("Interfaces                        : %u\n", n_ifaces);
+    printf("Input changes                     : %u\n", n_steps);
+    printf("Input checks                      : %llu\n", n_evals);
+    printf("Arbiter runs                      : %llu\n", n_runs);
+    printf("Keys written                      : %llu\n", n_key_writes);
+    printf("Input checks per second           : %.0f\n",
+           elapsed ? n_evals * 1e9 / elapsed : 0.0);
+    printf("Allocations per input check       : %.3f\n",
+           n_evals ? (double) sim_alloc_total() / n_evals : 0.0);
+    printf("Rows differing from the model     : %"PRIuSIZE"\n", n_mismatch);
+
+    for (i = 0; i < n_ifaces; i++) {
+        struct ovsrec_interface *ifrow = &ifaces[i].row;
+
+        free(ifrow->name);
+        smap_destroy(&ifrow->hw_intf_config);
+        smap_destroy(&ifrow->bond_status);
+        smap_destroy(&ifrow->forwarding_state);
+        smap_destroy(&ifrow->hw_status);
+    }
+    free(ifaces);
+
+    return n_mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
+} /* main */
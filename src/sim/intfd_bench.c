@@ -0,0 +1,663 @@
+/*
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+/************************************************************************//**
+ * @ingroup ops-intfd
+ *
+ * @file
+ * Micro-benchmark of the interface evaluation pipeline of ops-intfd.
+ *
+ * intfd_ovsdb_if.c is built into this program, so that its parsing and
+ * evaluation functions can be called directly on synthetic Interface rows,
+ * without an IDL or ovsdb-server.  The rows mix fixed RJ45 ports, SFP+
+ * ports and QSFP ports split into 4 lanes or not, with varied pluggable
+ * modules and user configurations.
+ *
+ * For each number of interfaces, every stage is run over all of them and
+ * reported in ns, heap allocations and cache misses per interface.  The
+ * cache misses come from perf_event_open() and are reported as n/a where
+ * it is not available.  The writes of hw_intf_config are applied to the
+ * synthetic rows, so the cost of the IDL itself is not included.  Last,
+ * the whole evaluation is run through the worker pool with 1 up to
+ * --threads threads.
+ *
+ ***************************************************************************/
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* The code under test, static functions included. */
+#include "intfd_ovsdb_if.c"
+
+#include <ovs-thread.h>
+#include <random.h>
+
+#include "sim_alloc.h"
+
+#define BENCH_DEFAULT_INTERFACES    "1024,4096,16384"
+#define BENCH_DEFAULT_ROUNDS        20
+
+/* A synthetic Interface row and the state intfd keeps for it. */
+struct bench_iface {
+    struct ovsrec_interface row;
+    struct iface intf;
+    struct bench_iface *parent;     /* Split parent, if a split child. */
+};
+
+struct bench_stage {
+    const char *name;
+    void (*prepare)(struct bench_iface *);  /* Not timed, may be NULL. */
+    void (*run)(struct bench_iface *);
+};
+
+static int cache_misses_fd = -1;
+
+/* The IDL setters used by set_intf_hw_config_in_db().  Apply them to the
+ * synthetic row instead. */
+void
+ovsrec_interface_set_error(const struct ovsrec_interface *row,
+                           const char *error)
+{
+    struct ovsrec_interface *ifrow = CONST_CAST(struct ovsrec_interface *, row);
+
+    free(ifrow->error);
+    ifrow->error = error ? xstrdup(error) : NULL;
+}
+
+void
+ovsrec_interface_set_hw_intf_config(const struct ovsrec_interface *row,
+                                    const struct smap *hw_intf_config)
+{
+    struct ovsrec_interface *ifrow = CONST_CAST(struct ovsrec_interface *, row);
+
+    smap_destroy(&ifrow->hw_intf_config);
+    smap_clone(&ifrow->hw_intf_config, hw_intf_config);
+}
+
+static void
+bench_cache_misses_open(void)
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof attr);
+    attr.size = sizeof attr;
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.inherit = 1;               /* Count the worker threads too. */
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    cache_misses_fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    if (cache_misses_fd < 0) {
+        VLOG_WARN("perf_event_open: %s, cache misses not reported",
+                  ovs_strerror(errno));
+    }
+#endif
+} /* bench_cache_misses_open */
+
+static void
+bench_cache_misses_start(void)
+{
+#ifdef __linux__
+    if (cache_misses_fd >= 0) {
+        ioctl(cache_misses_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(cache_misses_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+} /* bench_cache_misses_start */
+
+static unsigned long long
+bench_cache_misses_stop(void)
+{
+    uint64_t value = 0;
+
+#ifdef __linux__
+    if (cache_misses_fd >= 0) {
+        ioctl(cache_misses_fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(cache_misses_fd, &value, sizeof value) != sizeof value) {
+            value = 0;
+        }
+    }
+#endif
+    return value;
+} /* bench_cache_misses_stop */
+
+static void
+bench_init_row(struct bench_iface *b, char *name)
+{
+    struct ovsrec_interface *ifrow = &b->row;
+
+    ifrow->name = name;
+    ifrow->type = CONST_CAST(char *, OVSREC_INTERFACE_TYPE_SYSTEM);
+    smap_init(&ifrow->user_config);
+    smap_init(&ifrow->hw_intf_info);
+    smap_init(&ifrow->pm_info);
+    smap_init(&ifrow->hw_intf_config);
+
+    b->intf.name = name;
+    b->intf.type = ifrow->type;
+    b->intf.port_admin = PORT_ADMIN_CONFIG_UP;
+} /* bench_init_row */
+
+static void
+bench_add_hw_info(struct bench_iface *b, bool pluggable,
+                  const char *connector, const char *speeds,
+                  const char *max_speed)
+{
+    struct smap *hw_info = &b->row.hw_intf_info;
+
+    smap_add(hw_info, INTERFACE_HW_INTF_INFO_MAP_PLUGGABLE,
+             pluggable ? INTERFACE_HW_INTF_INFO_MAP_PLUGGABLE_TRUE : "false");
+    smap_add(hw_info, INTERFACE_HW_INTF_INFO_MAP_CONNECTOR, connector);
+    smap_add(hw_info, INTERFACE_HW_INTF_INFO_MAP_SPEEDS, speeds);
+    smap_add(hw_info, INTERFACE_HW_INTF_INFO_MAP_MAX_SPEED, max_speed);
+} /* bench_add_hw_info */
+
+/* Adds a pluggable module picked from 'modules', or none at all now and
+ * then.  A few modules are reported as unsupported. */
+static void
+bench_add_pm_info(struct bench_iface *b, const char *const *modules,
+                  size_t n_modules)
+{
+    struct smap *pm_info = &b->row.pm_info;
+
+    if (!random_range(8)) {
+        smap_add(pm_info, INTERFACE_PM_INFO_MAP_CONNECTOR,
+                 OVSREC_INTERFACE_PM_INFO_CONNECTOR_ABSENT);
+        return;
+    }
+
+    smap_add(pm_info, INTERFACE_PM_INFO_MAP_CONNECTOR,
+             modules[random_range(n_modules)]);
+    smap_add(pm_info, INTERFACE_PM_INFO_MAP_CONNECTOR_STATUS,
+             random_range(16)
+             ? OVSREC_INTERFACE_PM_INFO_CONNECTOR_STATUS_SUPPORTED
+             : OVSREC_INTERFACE_PM_INFO_CONNECTOR_STATUS_UNSUPPORTED);
+} /* bench_add_pm_info */
+
+/* Adds a user configuration: mostly admin up with default settings, with
+ * some autoneg, speeds, MTU, pause and duplex settings, valid or not. */
+static void
+bench_add_user_config(struct bench_iface *b, const char *speed)
+{
+    struct smap *user_config = &b->row.user_config;
+
+    if (random_range(16)) {
+        smap_add(user_config, INTERFACE_USER_CONFIG_MAP_ADMIN,
+                 OVSREC_INTERFACE_USER_CONFIG_ADMIN_UP);
+    }
+    switch (random_range(4)) {
+    case 0:
+        smap_add(user_config, INTERFACE_USER_CONFIG_MAP_AUTONEG,
+                 INTERFACE_USER_CONFIG_MAP_AUTONEG_ON);
+        break;
+    case 1:
+        smap_add(user_config, INTERFACE_USER_CONFIG_MAP_AUTONEG,
+                 INTERFACE_USER_CONFIG_MAP_AUTONEG_OFF);
+        break;
+    }
+    if (!random_range(8)) {
+        smap_add(user_config, INTERFACE_USER_CONFIG_MAP_SPEEDS, speed);
+    }
+    switch (random_range(32)) {
+    case 0:
+        smap_add(user_config, INTERFACE_USER_CONFIG_MAP_MTU, "jumbo");
+        break;
+    case 1: case 2: case 3:
+        smap_add(user_config, INTERFACE_USER_CONFIG_MAP_MTU, "9000");
+        break;
+    }
+    if (!random_range(4)) {
+        smap_add(user_config, INTERFACE_USER_CONFIG_MAP_PAUSE,
+                 INTERFACE_USER_CONFIG_MAP_PAUSE_RXTX);
+    }
+    if (!random_range(32)) {
+        smap_add(user_config, INTERFACE_USER_CONFIG_MAP_DUPLEX,
+                 INTERFACE_USER_CONFIG_MAP_DUPLEX_HALF);
+    }
+} /* bench_add_user_config */
+
+/* Generates at least 'n' interfaces into '*ifacesp' and returns their
+ * number.  1 in 4 ports is a fixed RJ45 port, 2 in 4 an SFP+ port and 1 in
+ * 4 a QSFP+ or QSFP28 port with its 4 split children, half of which are
+ * split. */
+static size_t
+bench_generate(size_t n, struct bench_iface **ifacesp)
+{
+    static const char *const sfp_modules[] = {
+        OVSREC_INTERFACE_PM_INFO_CONNECTOR_SFP_SR,
+        OVSREC_INTERFACE_PM_INFO_CONNECTOR_SFP_LR,
+        OVSREC_INTERFACE_PM_INFO_CONNECTOR_SFP_LRM,
+        OVSREC_INTERFACE_PM_INFO_CONNECTOR_SFP_DAC,
+        OVSREC_INTERFACE_PM_INFO_CONNECTOR_SFP_RJ45,
+    };
+    static const char *const qsfp_modules[] = {
+        OVSREC_INTERFACE_PM_INFO_CONNECTOR_QSFP_SR4,
+        OVSREC_INTERFACE_PM_INFO_CONNECTOR_QSFP_LR4,
+        OVSREC_INTERFACE_PM_INFO_CONNECTOR_QSFP_CR4,
+    };
+    static const char *const qsfp28_modules[] = {
+        OVSREC_INTERFACE_PM_INFO_CONNECTOR_QSFP28_SR4,
+        OVSREC_INTERFACE_PM_INFO_CONNECTOR_QSFP28_LR4,
+        OVSREC_INTERFACE_PM_INFO_CONNECTOR_QSFP28_CR4,
+    };
+    struct bench_iface *ifaces, *b, *child;
+    size_t n_ifaces = 0;
+    unsigned int port = 0;
+    bool qsfp28;
+    int i;
+
+    /* Room for a split port started just before reaching 'n'. */
+    ifaces = xcalloc(n + 4, sizeof *ifaces);
+    while (n_ifaces < n) {
+        b = &ifaces[n_ifaces++];
+        bench_init_row(b, xasprintf("%u", ++port));
+
+        switch (random_range(4)) {
+        case 0:
+            bench_add_hw_info(b, false,
+                              INTERFACE_HW_INTF_INFO_MAP_CONNECTOR_RJ45,
+                              "10,100,1000", "1000");
+            bench_add_user_config(b, "1000");
+            break;
+
+        case 1:
+        case 2:
+            bench_add_hw_info(b, true,
+                              INTERFACE_HW_INTF_INFO_MAP_CONNECTOR_SFP_PLUS,
+                              "1000,10000", "10000");
+            bench_add_pm_info(b, sfp_modules, ARRAY_SIZE(sfp_modules));
+            bench_add_user_config(b, "10000");
+            break;
+
+        default:
+            qsfp28 = random_range(2);
+            bench_add_hw_info(b, true,
+                              qsfp28
+                              ? INTERFACE_HW_INTF_INFO_MAP_CONNECTOR_QSFP28
+                              : INTERFACE_HW_INTF_INFO_MAP_CONNECTOR_QSFP_PLUS,
+                              qsfp28 ? "100000" : "40000",
+                              qsfp28 ? "100000" : "40000");
+            if (qsfp28) {
+                bench_add_pm_info(b, qsfp28_modules,
+                                  ARRAY_SIZE(qsfp28_modules));
+            } else {
+                bench_add_pm_info(b, qsfp_modules, ARRAY_SIZE(qsfp_modules));
+            }
+            bench_add_user_config(b, qsfp28 ? "100000" : "40000");
+            if (random_range(2)) {
+                smap_add(&b->row.user_config,
+                         INTERFACE_USER_CONFIG_MAP_LANE_SPLIT,
+                         INTERFACE_USER_CONFIG_MAP_LANE_SPLIT_SPLIT);
+            }
+
+            b->intf.n_split_children = 4;
+            b->intf.split_children = xcalloc(4,
+                                             sizeof *b->intf.split_children);
+            for (i = 0; i < 4; i++) {
+                child = &ifaces[n_ifaces++];
+                bench_init_row(child, xasprintf("%u-%d", port, i + 1));
+                bench_add_hw_info(child, true,
+                                  qsfp28
+                                  ? INTERFACE_HW_INTF_INFO_MAP_CONNECTOR_QSFP28
+                                  : INTERFACE_HW_INTF_INFO_MAP_CONNECTOR_QSFP_PLUS,
+                                  qsfp28 ? "25000" : "10000",
+                                  qsfp28 ? "25000" : "10000");
+                bench_add_user_config(child, qsfp28 ? "25000" : "10000");
+                child->parent = b;
+                child->intf.split_parent = &b->intf;
+                b->intf.split_children[i] = &child->intf;
+            }
+            break;
+        }
+    }
+
+    *ifacesp = ifaces;
+    return n_ifaces;
+} /* bench_generate */
+
+static void
+bench_destroy(struct bench_iface *ifaces, size_t n_ifaces)
+{
+    size_t i;
+
+    for (i = 0; i < n_ifaces; i++) {
+        struct ovsrec_interface *ifrow = &ifaces[i].row;
+
+        free(ifrow->name);
+        free(ifrow->error);
+        smap_destroy(&ifrow->user_config);
+        smap_destroy(&ifrow->hw_intf_info);
+        smap_destroy(&ifrow->pm_info);
+        smap_destroy(&ifrow->hw_intf_config);
+        free(ifaces[i].intf.split_children);
+    }
+    free(ifaces);
+} /* bench_destroy */
+
+static void
+bench_parse_hw_info(struct bench_iface *b)
+{
+    intfd_parse_hw_info(&b->intf.hw_info, &b->row.hw_intf_info);
+} /* bench_parse_hw_info */
+
+static void
+bench_parse_user_cfg(struct bench_iface *b)
+{
+    intfd_parse_user_cfg(&b->intf.user_cfg, &b->row.user_config,
+                         &b->row.hw_intf_info);
+} /* bench_parse_user_cfg */
+
+static void
+bench_parse_pm_info(struct bench_iface *b)
+{
+    if (b->parent) {
+        intfd_parse_split_pm_info(&b->intf.pm_info, &b->parent->row.pm_info);
+    } else {
+        intfd_parse_pm_info(&b->intf.hw_info, &b->intf.pm_info,
+                            &b->row.pm_info);
+    }
+} /* bench_parse_pm_info */
+
+static void
+bench_validate_capability(struct bench_iface *b)
+{
+    validate_n_set_interface_capability(&b->intf);
+} /* bench_validate_capability */
+
+static void
+bench_calc_op_state(struct bench_iface *b)
+{
+    calc_intf_op_state_n_reason(&b->intf);
+} /* bench_calc_op_state */
+
+/* Clears the row, so that every round serializes and writes. */
+static void
+bench_clear_hw_config(struct bench_iface *b)
+{
+    smap_clear(&b->row.hw_intf_config);
+    free(b->row.error);
+    b->row.error = NULL;
+} /* bench_clear_hw_config */
+
+static void
+bench_hw_config_write(struct bench_iface *b)
+{
+    set_intf_hw_config_in_db(&b->row, &b->intf);
+} /* bench_hw_config_write */
+
+static const struct bench_stage bench_stages[] = {
+    {"intfd_parse_hw_info", NULL, bench_parse_hw_info},
+    {"intfd_parse_user_cfg", NULL, bench_parse_user_cfg},
+    {"intfd_parse_pm_info", NULL, bench_parse_pm_info},
+    {"validate_n_set_interface_capability", NULL, bench_validate_capability},
+    {"calc_intf_op_state_n_reason", NULL, bench_calc_op_state},
+    {"set_intf_hw_config_in_db", bench_clear_hw_config,
+     bench_hw_config_write},
+};
+
+static void
+bench_print_row(const char *name, long long int nsec,
+                unsigned long long allocs, unsigned long long misses,
+                size_t n)
+{
+    printf("  %-36s %10.1f %10.3f ", name, (double) nsec / n,
+           (double) allocs / n);
+    if (cache_misses_fd >= 0) {
+        printf("%10.2f\n", (double) misses / n);
+    } else {
+        printf("%10s\n", "n/a");
+    }
+} /* bench_print_row */
+
+static void
+bench_run_stage(const struct bench_stage *stage, struct bench_iface *ifaces,
+                size_t n_ifaces, unsigned int rounds)
+{
+    unsigned long long allocs = 0, misses = 0, base;
+    long long int elapsed = 0, start;
+    unsigned int r;
+    size_t i;
+
+    for (r = 0; r < rounds; r++) {
+        if (stage->prepare) {
+            for (i = 0; i < n_ifaces; i++) {
+                stage->prepare(&ifaces[i]);
+            }
+        }
+
+        base = sim_alloc_total();
+        bench_cache_misses_start();
+        sim_alloc_count(true);
+        start = intfd_perf_start();
+        for (i = 0; i < n_ifaces; i++) {
+            stage->run(&ifaces[i]);
+        }
+        elapsed += intfd_perf_start() - start;
+        sim_alloc_count(false);
+        misses += bench_cache_misses_stop();
+        allocs += sim_alloc_total() - base;
+    }
+
+    bench_print_row(stage->name, elapsed, allocs, misses,
+                    (size_t) rounds * n_ifaces);
+} /* bench_run_stage */
+
+/* Runs intfd_evaluate_intf() over every interface through the worker
+ * pool, the way intfd_evaluate_pending() does for large work sets. */
+static void
+bench_run_threads(struct bench_iface *ifaces, size_t n_ifaces,
+                  unsigned int rounds, unsigned int max_threads)
+{
+    long long int elapsed, start, single = 0;
+    unsigned long long misses;
+    unsigned int n_threads, r;
+    void **items;
+    size_t i;
+
+    items = xmalloc(n_ifaces * sizeof *items);
+    for (i = 0; i < n_ifaces; i++) {
+        items[i] = &ifaces[i].intf;
+    }
+
+    for (n_threads = 1; n_threads <= max_threads;
+         n_threads = (n_threads < max_threads
+                      ? MIN(n_threads * 2, max_threads) : n_threads + 1)) {
+        intfd_workers_init(n_threads);
+
+        elapsed = 0;
+        misses = 0;
+        for (r = 0; r < rounds; r++) {
+            for (i = 0; i < n_ifaces; i++) {
+                ifaces[i].intf.eval_pending = true;
+            }
+
+            bench_cache_misses_start();
+            start = intfd_perf_start();
+            intfd_workers_run(intfd_evaluate_cb, items, n_ifaces);
+            elapsed += intfd_perf_start() - start;
+            misses += bench_cache_misses_stop();
+        }
+        intfd_workers_exit();
+
+        if (n_threads == 1) {
+            single = elapsed;
+        }
+        printf("  %-8u %10.1f %10.2f ", n_threads,
+               (double) elapsed / rounds / n_ifaces,
+               elapsed ? (double) single / elapsed : 0.0);
+        if (cache_misses_fd >= 0) {
+            printf("%10.2f\n", (double) misses / rounds / n_ifaces);
+        } else {
+            printf("%10s\n", "n/a");
+        }
+    }
+
+    free(items);
+} /* bench_run_threads */
+
+static void
+bench_run(size_t n, unsigned int rounds, unsigned int max_threads)
+{
+    struct bench_iface *ifaces;
+    size_t n_ifaces, i;
+
+    n_ifaces = bench_generate(n, &ifaces);
+
+    /* Evaluate once, so that every stage starts from the state intfd
+     * would have. */
+    for (i = 0; i < n_ifaces; i++) {
+        bench_parse_hw_info(&ifaces[i]);
+        bench_parse_user_cfg(&ifaces[i]);
+        bench_parse_pm_info(&ifaces[i]);
+        intfd_evaluate_intf(&ifaces[i].intf);
+    }
+
+    printf("%"PRIuSIZE" interfaces, %u rounds\n", n_ifaces, rounds);
+    printf("  %-36s %10s %10s %10s\n", "stage", "ns/intf", "allocs/intf",
+           "misses/intf");
+    for (i = 0; i < ARRAY_SIZE(bench_stages); i++) {
+        bench_run_stage(&bench_stages[i], ifaces, n_ifaces, rounds);
+    }
+
+    printf("  %-8s %10s %10s %10s\n", "threads", "ns/intf", "speedup",
+           "misses/intf");
+    bench_run_threads(ifaces, n_ifaces, rounds, max_threads);
+    printf("\n");
+
+    bench_destroy(ifaces, n_ifaces);
+} /* bench_run */
+
+static void
+usage(void)
+{
+    printf("%s: micro-benchmark of the ops-intfd evaluation pipeline\n"
+           "usage: %s [OPTIONS]\n"
+           "\nOptions:\n"
+           "  --interfaces=N[,N...]   numbers of interfaces (default: %s)\n"
+           "  --rounds=N              runs of each stage (default: %d)\n"
+           "  --threads=N             maximum evaluation threads\n"
+           "                          (default: number of cores)\n"
+           "  --seed=N                seed of the generated interfaces\n"
+           "  -h, --help              display this help message\n",
+           program_name, program_name, BENCH_DEFAULT_INTERFACES,
+           BENCH_DEFAULT_ROUNDS);
+    exit(EXIT_SUCCESS);
+} /* usage */
+
+int
+main(int argc, char *argv[])
+{
+    enum {
+        OPT_INTERFACES = UCHAR_MAX + 1,
+        OPT_ROUNDS,
+        OPT_THREADS,
+        OPT_SEED,
+    };
+    static const struct option long_options[] = {
+        {"help",        no_argument, NULL, 'h'},
+        {"interfaces",  required_argument, NULL, OPT_INTERFACES},
+        {"rounds",      required_argument, NULL, OPT_ROUNDS},
+        {"threads",     required_argument, NULL, OPT_THREADS},
+        {"seed",        required_argument, NULL, OPT_SEED},
+        {NULL, 0, NULL, 0},
+    };
+    const char *sizes = BENCH_DEFAULT_INTERFACES;
+    unsigned int rounds = BENCH_DEFAULT_ROUNDS;
+    unsigned int max_threads = 0;
+    unsigned int seed = 0;
+    char *short_options;
+    char *copy, *token, *save_ptr = NULL;
+    unsigned int n;
+
+    set_program_name(argv[0]);
+
+    short_options = long_options_to_short_options(long_options);
+    for (;;) {
+        int c = getopt_long(argc, argv, short_options, long_options, NULL);
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+        case 'h':
+            usage();
+
+        case OPT_INTERFACES:
+            sizes = optarg;
+            break;
+
+        case OPT_ROUNDS:
+            if (!str_to_uint(optarg, 10, &rounds) || !rounds) {
+                ovs_fatal(0, "--rounds argument must be a positive integer");
+            }
+            break;
+
+        case OPT_THREADS:
+            if (!str_to_uint(optarg, 10, &max_threads) || !max_threads) {
+                ovs_fatal(0, "--threads argument must be a positive "
+                          "integer");
+            }
+            break;
+
+        case OPT_SEED:
+            if (!str_to_uint(optarg, 10, &seed)) {
+                ovs_fatal(0, "--seed argument must be a non-negative "
+                          "integer");
+            }
+            break;
+
+        case '?':
+            exit(EXIT_FAILURE);
+
+        default:
+            abort();
+        }
+    }
+    free(short_options);
+
+    if (seed) {
+        random_set_seed(seed);
+    }
+    if (!max_threads) {
+        max_threads = MAX(count_cpu_cores(), 1);
+    }
+
+    /* The subsystem MTU bounds the valid user MTU. */
+    base_subsys.mtu = 9192;
+
+    /* Before any worker thread exists, so that they inherit the counter. */
+    bench_cache_misses_open();
+
+    copy = xstrdup(sizes);
+    for (token = strtok_r(copy, ",", &save_ptr); token;
+         token = strtok_r(NULL, ",", &save_ptr)) {
+        if (!str_to_uint(token, 10, &n) || !n) {
+            ovs_fatal(0, "--interfaces argument must be a list of positive "
+                      "integers");
+        }
+        bench_run(n, rounds, max_threads);
+    }
+    free(copy);
+
+    return EXIT_SUCCESS;
+} /* main */
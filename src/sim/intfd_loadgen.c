@@ -0,0 +1,1150 @@
+/*
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+/************************************************************************//**
+ * @ingroup ops-intfd
+ *
+ * @file
+ * Load generator for a running ops-intfd.
+ *
+ * ops-intfd-loadgen connects to ovsdb-server and inserts N synthetic
+ * Interface rows, each in a Port of its own, with realistic hw_intf_info,
+ * pm_info and split relationships: fixed RJ45 ports, SFP+ ports and QSFP+
+ * ports with 4 split children.  The time until ops-intfd has written the
+ * error, hw_intf_config and forwarding_state of all of them is reported.
+ *
+ * It then applies changes at --rate events per second for --duration
+ * seconds, picked from the enabled streams:
+ *
+ *   admin     user_config:admin of an interface toggled.
+ *   module    pluggable module of an SFP+ or QSFP+ port removed or inserted.
+ *   lag       interface moved into one of --lags LAG ports with a blocked
+ *             bond_status, or back into its own port.
+ *   split     lane_split of a QSFP+ port toggled.
+ *
+ * For each event, the time from the commit of the change to the moment
+ * ops-intfd's outputs converge to the expected Interface:error and
+ * forwarding_state:forwarding, of the parent and the children for a split
+ * toggle, is recorded.  The expected error is derived from the precedence
+ * of calc_intf_op_state_n_reason(), with the error each interface had when
+ * it was first evaluated in its nominal state as the baseline.  An
+ * interface has at most one event pending at a time.  An event that does
+ * not converge within --timeout ms is counted as timed out.
+ *
+ * The ports are attached to vrf_default, without which ovsdb-server
+ * garbage-collects them.  The rows are named "lg-*".  Any left over by a previous run are deleted
+ * at startup, and the new ones at exit unless --keep is given.
+ *
+ ***************************************************************************/
+
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <config.h>
+#include <command-line.h>
+#include <dirs.h>
+#include <ovsdb-idl.h>
+#include <ovsdb-idl-provider.h>
+#include <poll-loop.h>
+#include <random.h>
+#include <smap.h>
+#include <timeval.h>
+#include <util.h>
+#include <uuid.h>
+#include <openvswitch/vlog.h>
+#include <openswitch-idl.h>
+#include <vswitch-idl.h>
+
+#include "intfd_perf.h"
+
+VLOG_DEFINE_THIS_MODULE(intfd_loadgen);
+
+#define LG_PREFIX                   "lg-"
+#define LG_VRF                      "vrf_default"
+#define LG_DEFAULT_INTERFACES       4096
+#define LG_DEFAULT_LAGS             64
+#define LG_DEFAULT_RATE             100
+#define LG_DEFAULT_DURATION         10
+#define LG_DEFAULT_TIMEOUT          5000
+#define LG_SETUP_TIMEOUT            60000
+#define LG_SETUP_CHUNK              256     /* Interfaces per transaction. */
+#define LG_MAX_EVENTS_PER_TXN       256
+#define LG_SPLIT_CHILDREN           4
+
+enum lg_kind {
+    LG_FIXED,
+    LG_SFP,
+    LG_QSFP,
+    LG_CHILD,
+};
+
+enum lg_stream {
+    LG_STREAM_ADMIN,
+    LG_STREAM_MODULE,
+    LG_STREAM_LAG,
+    LG_STREAM_SPLIT,
+    LG_N_STREAMS
+};
+
+static const char *lg_stream_names[LG_N_STREAMS] = {
+    "admin", "module", "lag", "split",
+};
+
+/* A synthetic interface and the inputs the load generator gave it. */
+struct lg_iface {
+    char *name;
+    enum lg_kind kind;
+    struct uuid uuid;               /* Interface row. */
+    struct uuid port_uuid;          /* Port of its own. */
+    struct lg_iface *parent;        /* Split parent, if a split child. */
+    const char *module;             /* Pluggable module, if pluggable. */
+
+    bool admin_down;
+    bool module_absent;
+    bool split;                     /* QSFP+ port with its lanes split. */
+    int lag;                        /* LAG port index, -1 if none. */
+
+    /* Error of the interface in its nominal state, i.e. admin up, module
+     * present and lanes as configured at startup, once observed. */
+    bool base_known;
+    char *base_error;
+
+    bool busy;                      /* An event of it is pending. */
+};
+
+/* A change whose outcome has not been observed yet. */
+struct lg_event {
+    enum lg_stream stream;
+    struct lg_iface *ifaces;        /* The interfaces to check... */
+    size_t n_ifaces;                /* ...consecutive in 'ifaces'. */
+    long long int start;            /* intfd_perf_start() of the commit. */
+};
+
+struct lg_stats {
+    unsigned long long int events;
+    unsigned long long int timeouts;
+    struct intfd_perf_histogram latency;
+};
+
+static struct ovsdb_idl *idl;
+static struct lg_iface *ifaces;
+static size_t n_ifaces;
+static struct uuid *lag_uuids;
+static unsigned int n_lags = LG_DEFAULT_LAGS;
+
+static struct lg_event *events;
+static size_t n_events, allocated_events;
+static struct lg_stats stats[LG_N_STREAMS];
+
+static void
+lg_idl_block(void)
+{
+    ovsdb_idl_wait(idl);
+    poll_block();
+    ovsdb_idl_run(idl);
+} /* lg_idl_block */
+
+/* Commits 'txn' and exits on failure. */
+static void
+lg_commit(struct ovsdb_idl_txn *txn)
+{
+    enum ovsdb_idl_txn_status status;
+
+    status = ovsdb_idl_txn_commit_block(txn);
+    if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+        ovs_fatal(0, "transaction failed (%s)",
+                  ovsdb_idl_txn_status_to_string(status));
+    }
+} /* lg_commit */
+
+static bool
+lg_is_own(const char *name)
+{
+    return !strncmp(name, LG_PREFIX, strlen(LG_PREFIX));
+} /* lg_is_own */
+
+static const struct ovsrec_vrf *
+lg_vrf_find(void)
+{
+    const struct ovsrec_vrf *vrf_row;
+
+    OVSREC_VRF_FOR_EACH (vrf_row, idl) {
+        if (!strcmp(vrf_row->name, LG_VRF)) {
+            return vrf_row;
+        }
+    }
+    return NULL;
+} /* lg_vrf_find */
+
+/* Sets the ports of 'vrf_row' to its current ones, less the "lg-*" ones if
+ * 'remove_own', plus the 'n' ports of 'added'. */
+static void
+lg_vrf_set_ports(const struct ovsrec_vrf *vrf_row, bool remove_own,
+                 struct ovsrec_port **added, size_t n)
+{
+    struct ovsrec_port **ports;
+    size_t n_ports = 0, i;
+
+    ports = xmalloc(MAX(vrf_row->n_ports + n, 1) * sizeof *ports);
+    for (i = 0; i < vrf_row->n_ports; i++) {
+        if (!remove_own || !lg_is_own(vrf_row->ports[i]->name)) {
+            ports[n_ports++] = vrf_row->ports[i];
+        }
+    }
+    for (i = 0; i < n; i++) {
+        ports[n_ports++] = added[i];
+    }
+    ovsrec_vrf_set_ports(vrf_row, ports, n_ports);
+    free(ports);
+} /* lg_vrf_set_ports */
+
+/* Deletes the rows of a previous run. */
+static void
+lg_cleanup(void)
+{
+    const struct ovsrec_interface *ifrow, *next_ifrow;
+    const struct ovsrec_port *port_row, *next_port_row;
+    const struct ovsrec_vrf *vrf_row;
+    struct ovsdb_idl_txn *txn;
+
+    txn = ovsdb_idl_txn_create(idl);
+    vrf_row = lg_vrf_find();
+    if (vrf_row) {
+        lg_vrf_set_ports(vrf_row, true, NULL, 0);
+    }
+    OVSREC_PORT_FOR_EACH_SAFE (port_row, next_port_row, idl) {
+        if (lg_is_own(port_row->name)) {
+            ovsrec_port_delete(port_row);
+        }
+    }
+    OVSREC_INTERFACE_FOR_EACH_SAFE (ifrow, next_ifrow, idl) {
+        if (lg_is_own(ifrow->name)) {
+            ovsrec_interface_delete(ifrow);
+        }
+    }
+    lg_commit(txn);
+    ovsdb_idl_txn_destroy(txn);
+} /* lg_cleanup */
+
+/* ops-intfd does not evaluate interfaces until System:cur_cfg is set. */
+static void
+lg_system_configure(void)
+{
+    const struct ovsrec_system *system_row;
+    struct ovsdb_idl_txn *txn;
+
+    system_row = ovsrec_system_first(idl);
+    if (system_row && system_row->cur_cfg > 0) {
+        return;
+    }
+
+    txn = ovsdb_idl_txn_create(idl);
+    if (!system_row) {
+        system_row = ovsrec_system_insert(txn);
+    }
+    ovsrec_system_set_cur_cfg(system_row, 1);
+    lg_commit(txn);
+    ovsdb_idl_txn_destroy(txn);
+} /* lg_system_configure */
+
+static void
+lg_iface_init(struct lg_iface *iface, char *name, enum lg_kind kind,
+              const char *module)
+{
+    iface->name = name;
+    iface->kind = kind;
+    iface->module = module;
+    iface->lag = -1;
+} /* lg_iface_init */
+
+/* Generates at least 'n' interfaces.  1 in 4 ports is a fixed RJ45 port,
+ * 2 in 4 an SFP+ port and 1 in 4 a QSFP+ port followed by its 4 split
+ * children.  Every port starts with a supported module, if pluggable,
+ * admin up and its lanes not split. */
+static void
+lg_generate(size_t n)
+{
+    static const char *const sfp_modules[] = {
+        OVSREC_INTERFACE_PM_INFO_CONNECTOR_SFP_SR,
+        OVSREC_INTERFACE_PM_INFO_CONNECTOR_SFP_LR,
+        OVSREC_INTERFACE_PM_INFO_CONNECTOR_SFP_LRM,
+    };
+    static const char *const qsfp_modules[] = {
+        OVSREC_INTERFACE_PM_INFO_CONNECTOR_QSFP_SR4,
+        OVSREC_INTERFACE_PM_INFO_CONNECTOR_QSFP_LR4,
+    };
+    struct lg_iface *iface;
+    unsigned int port = 0;
+    const char *module;
+    int i;
+
+    /* Room for a split port started just before reaching 'n'. */
+    ifaces = xcalloc(n + LG_SPLIT_CHILDREN, sizeof *ifaces);
+    while (n_ifaces < n) {
+        iface = &ifaces[n_ifaces++];
+        port++;
+
+        switch (random_range(4)) {
+        case 0:
+            lg_iface_init(iface, xasprintf(LG_PREFIX "%u", port), LG_FIXED,
+                          NULL);
+            break;
+
+        case 1:
+        case 2:
+            lg_iface_init(iface, xasprintf(LG_PREFIX "%u", port), LG_SFP,
+                          sfp_modules[random_range(ARRAY_SIZE(sfp_modules))]);
+            break;
+
+        default:
+            module = qsfp_modules[random_range(ARRAY_SIZE(qsfp_modules))];
+            lg_iface_init(iface, xasprintf(LG_PREFIX "%u", port), LG_QSFP,
+                          module);
+            for (i = 0; i < LG_SPLIT_CHILDREN; i++) {
+                lg_iface_init(&ifaces[n_ifaces],
+                              xasprintf(LG_PREFIX "%u-%d", port, i + 1),
+                              LG_CHILD, module);
+                ifaces[n_ifaces++].parent = iface;
+            }
+            break;
+        }
+    }
+} /* lg_generate */
+
+static void
+lg_set_pm_info(const struct ovsrec_interface *ifrow,
+               const struct lg_iface *iface)
+{
+    struct smap pm_info = SMAP_INITIALIZER(&pm_info);
+
+    if (iface->module_absent) {
+        smap_add(&pm_info, INTERFACE_PM_INFO_MAP_CONNECTOR,
+                 OVSREC_INTERFACE_PM_INFO_CONNECTOR_ABSENT);
+    } else {
+        smap_add(&pm_info, INTERFACE_PM_INFO_MAP_CONNECTOR, iface->module);
+        smap_add(&pm_info, INTERFACE_PM_INFO_MAP_CONNECTOR_STATUS,
+                 OVSREC_INTERFACE_PM_INFO_CONNECTOR_STATUS_SUPPORTED);
+    }
+    ovsrec_interface_set_pm_info(ifrow, &pm_info);
+    smap_destroy(&pm_info);
+} /* lg_set_pm_info */
+
+static struct ovsrec_interface *
+lg_insert_iface(struct ovsdb_idl_txn *txn, struct lg_iface *iface)
+{
+    struct smap hw_info = SMAP_INITIALIZER(&hw_info);
+    struct smap user_config = SMAP_INITIALIZER(&user_config);
+    struct ovsrec_interface *ifrow;
+    const char *connector, *speeds;
+
+    switch (iface->kind) {
+    case LG_FIXED:
+        connector = INTERFACE_HW_INTF_INFO_MAP_CONNECTOR_RJ45;
+        speeds = "1000";
+        break;
+    case LG_SFP:
+        connector = INTERFACE_HW_INTF_INFO_MAP_CONNECTOR_SFP_PLUS;
+        speeds = "10000";
+        break;
+    case LG_QSFP:
+        connector = INTERFACE_HW_INTF_INFO_MAP_CONNECTOR_QSFP_PLUS;
+        speeds = "40000";
+        break;
+    case LG_CHILD:
+    default:
+        connector = INTERFACE_HW_INTF_INFO_MAP_CONNECTOR_QSFP_PLUS;
+        speeds = "10000";
+        break;
+    }
+
+    ifrow = ovsrec_interface_insert(txn);
+    ovsrec_interface_set_name(ifrow, iface->name);
+    ovsrec_interface_set_type(ifrow, OVSREC_INTERFACE_TYPE_SYSTEM);
+
+    smap_add(&hw_info, INTERFACE_HW_INTF_INFO_MAP_PLUGGABLE,
+             iface->module ? INTERFACE_HW_INTF_INFO_MAP_PLUGGABLE_TRUE
+                           : "false");
+    smap_add(&hw_info, INTERFACE_HW_INTF_INFO_MAP_CONNECTOR, connector);
+    smap_add(&hw_info, INTERFACE_HW_INTF_INFO_MAP_SPEEDS, speeds);
+    smap_add(&hw_info, INTERFACE_HW_INTF_INFO_MAP_MAX_SPEED, speeds);
+    ovsrec_interface_set_hw_intf_info(ifrow, &hw_info);
+    smap_destroy(&hw_info);
+
+    if (iface->module) {
+        lg_set_pm_info(ifrow, iface);
+    }
+
+    smap_add(&user_config, INTERFACE_USER_CONFIG_MAP_ADMIN,
+             OVSREC_INTERFACE_USER_CONFIG_ADMIN_UP);
+    ovsrec_interface_set_user_config(ifrow, &user_config);
+    smap_destroy(&user_config);
+
+    return ifrow;
+} /* lg_insert_iface */
+
+static struct ovsrec_port *
+lg_insert_port(struct ovsdb_idl_txn *txn, const char *name,
+               struct ovsrec_interface **ifrows, size_t n)
+{
+    struct ovsrec_port *port_row;
+
+    port_row = ovsrec_port_insert(txn);
+    ovsrec_port_set_name(port_row, name);
+    ovsrec_port_set_admin(port_row, "up");
+    ovsrec_port_set_interfaces(port_row, ifrows, n);
+    return port_row;
+} /* lg_insert_port */
+
+/* Replaces '*uuid', the temporary UUID of a row inserted by 'txn', by its
+ * permanent one once 'txn' has committed.  The rows inserted by a
+ * transaction are freed when it completes, so their temporary UUIDs must
+ * be kept beforehand. */
+static void
+lg_insert_uuid(const struct ovsdb_idl_txn *txn, struct uuid *uuid)
+{
+    const struct uuid *permanent;
+
+    permanent = ovsdb_idl_txn_get_insert_uuid(txn, uuid);
+    if (!permanent) {
+        ovs_fatal(0, "inserted row "UUID_FMT" not found", UUID_ARGS(uuid));
+    }
+    *uuid = *permanent;
+} /* lg_insert_uuid */
+
+/* Inserts the LAG ports and the interfaces, LG_SETUP_CHUNK interfaces per
+ * transaction, a QSFP+ port and its children always in the same one.
+ * Each transaction also attaches its ports to vrf_default. */
+static void
+lg_insert_all(void)
+{
+    struct ovsrec_interface *children[LG_SPLIT_CHILDREN];
+    struct ovsrec_interface *ifrow, *parent = NULL;
+    struct ovsrec_port *port_row, **ports;
+    struct ovsdb_idl_txn *txn;
+    struct lg_iface *iface;
+    size_t first, i, j;
+    char *name;
+
+    if (!lg_vrf_find()) {
+        ovs_fatal(0, "VRF %s not found", LG_VRF);
+    }
+
+    /* The ports inserted by the current transaction. */
+    ports = xmalloc(MAX(n_lags, LG_SETUP_CHUNK + LG_SPLIT_CHILDREN)
+                    * sizeof *ports);
+
+    lag_uuids = xcalloc(MAX(n_lags, 1), sizeof *lag_uuids);
+    txn = ovsdb_idl_txn_create(idl);
+    for (i = 0; i < n_lags; i++) {
+        name = xasprintf(LG_PREFIX "lag%"PRIuSIZE, i + 1);
+        port_row = lg_insert_port(txn, name, NULL, 0);
+        ports[i] = port_row;
+        lag_uuids[i] = port_row->header_.uuid;
+        free(name);
+    }
+    lg_vrf_set_ports(lg_vrf_find(), false, ports, n_lags);
+    lg_commit(txn);
+    for (i = 0; i < n_lags; i++) {
+        lg_insert_uuid(txn, &lag_uuids[i]);
+    }
+    ovsdb_idl_txn_destroy(txn);
+
+    for (first = 0; first < n_ifaces; first = i) {
+        /* Children follow their parent, so a chunk never ends between
+         * them. */
+        txn = ovsdb_idl_txn_create(idl);
+        for (i = first;
+             i < n_ifaces
+             && (i - first < LG_SETUP_CHUNK || ifaces[i].kind == LG_CHILD);
+             i++) {
+            iface = &ifaces[i];
+            ifrow = lg_insert_iface(txn, iface);
+            port_row = lg_insert_port(txn, iface->name, &ifrow, 1);
+            ports[i - first] = port_row;
+            iface->uuid = ifrow->header_.uuid;
+            iface->port_uuid = port_row->header_.uuid;
+
+            if (iface->kind == LG_QSFP) {
+                parent = ifrow;
+            } else if (iface->kind == LG_CHILD) {
+                ovsrec_interface_set_split_parent(ifrow, parent);
+                children[iface - iface->parent - 1] = ifrow;
+                if (iface - iface->parent == LG_SPLIT_CHILDREN) {
+                    ovsrec_interface_set_split_children(parent, children,
+                                                        LG_SPLIT_CHILDREN);
+                }
+            }
+        }
+        lg_vrf_set_ports(lg_vrf_find(), false, ports, i - first);
+        lg_commit(txn);
+
+        for (j = first; j < i; j++) {
+            lg_insert_uuid(txn, &ifaces[j].uuid);
+            lg_insert_uuid(txn, &ifaces[j].port_uuid);
+        }
+        ovsdb_idl_txn_destroy(txn);
+    }
+    free(ports);
+} /* lg_insert_all */
+
+/* Sets '*errorp' to the error 'iface' is expected to converge to, NULL if
+ * it is expected to be enabled.  Returns false if it is not known. */
+static bool
+lg_expected_error(const struct lg_iface *iface, const char **errorp)
+{
+    if (iface->kind == LG_QSFP && iface->split) {
+        *errorp = OVSREC_INTERFACE_ERROR_LANES_SPLIT;
+    } else if (iface->kind == LG_CHILD && !iface->parent->split) {
+        *errorp = OVSREC_INTERFACE_ERROR_LANES_NOT_SPLIT;
+    } else if (!iface->base_known) {
+        return false;
+    } else if (iface->admin_down) {
+        *errorp = OVSREC_INTERFACE_ERROR_ADMIN_DOWN;
+    } else if (iface->module_absent) {
+        *errorp = OVSREC_INTERFACE_ERROR_MODULE_MISSING;
+    } else {
+        *errorp = iface->base_error;
+    }
+    return true;
+} /* lg_expected_error */
+
+static bool
+lg_str_equal(const char *a, const char *b)
+{
+    return a == b || (a && b && !strcmp(a, b));
+} /* lg_str_equal */
+
+/* Returns true if the outputs of 'iface' have converged.  The first time
+ * an interface converges in its nominal state, its error is kept as its
+ * baseline. */
+static bool
+lg_iface_converged(struct lg_iface *iface)
+{
+    const struct ovsrec_interface *ifrow;
+    const char *enable, *forwarding, *error;
+
+    ifrow = ovsrec_interface_get_for_uuid(idl, &iface->uuid);
+    if (!ifrow) {
+        return false;
+    }
+
+    /* Not evaluated yet. */
+    enable = smap_get(&ifrow->hw_intf_config,
+                      INTERFACE_HW_INTF_CONFIG_MAP_ENABLE);
+    forwarding = smap_get(&ifrow->forwarding_state,
+                          INTERFACE_FORWARDING_STATE_MAP_FORWARDING);
+    if (!enable || !forwarding) {
+        return false;
+    }
+
+    if (!lg_expected_error(iface, &error)) {
+        if (lg_str_equal(ifrow->error,
+                         OVSREC_INTERFACE_ERROR_LANES_NOT_SPLIT)) {
+            return false;
+        }
+        iface->base_known = true;
+        iface->base_error = ifrow->error ? xstrdup(ifrow->error) : NULL;
+        return true;
+    }
+
+    return (lg_str_equal(error, ifrow->error)
+            && !strcmp(forwarding, !error && iface->lag < 0
+                                   ? INTERFACE_FORWARDING_STATE_FORWARDING_TRUE
+                                   : INTERFACE_FORWARDING_STATE_FORWARDING_FALSE));
+} /* lg_iface_converged */
+
+/* Waits until every interface has converged.  Returns the time it took, in
+ * ns, or -1 on timeout. */
+static long long int
+lg_wait_setup(long long int start)
+{
+    long long int deadline = time_msec() + LG_SETUP_TIMEOUT;
+    size_t next = 0;
+
+    for (;;) {
+        while (next < n_ifaces && lg_iface_converged(&ifaces[next])) {
+            next++;
+        }
+        if (next == n_ifaces) {
+            return intfd_perf_start() - start;
+        }
+        if (time_msec() >= deadline) {
+            return -1;
+        }
+
+        poll_timer_wait_until(deadline);
+        lg_idl_block();
+    }
+} /* lg_wait_setup */
+
+static bool
+lg_can_start(const struct lg_iface *iface, enum lg_stream stream)
+{
+    const char *error;
+    size_t i;
+
+    if (iface->busy || !iface->base_known || iface->kind == LG_CHILD
+        || (iface->kind == LG_QSFP && iface->split
+            && stream != LG_STREAM_SPLIT)) {
+        return false;
+    }
+
+    switch (stream) {
+    case LG_STREAM_ADMIN:
+        return true;
+
+    case LG_STREAM_MODULE:
+        return iface->module && !iface->admin_down;
+
+    case LG_STREAM_LAG:
+        /* Joining a LAG only changes the outputs of an enabled interface. */
+        return n_lags && (iface->lag >= 0
+                          || (lg_expected_error(iface, &error) && !error));
+
+    case LG_STREAM_SPLIT:
+        if (iface->kind != LG_QSFP) {
+            return false;
+        }
+        for (i = 1; i <= LG_SPLIT_CHILDREN; i++) {
+            if (iface[i].busy) {
+                return false;
+            }
+        }
+        return true;
+
+    case LG_N_STREAMS:
+    default:
+        OVS_NOT_REACHED();
+    }
+} /* lg_can_start */
+
+/* Moves 'iface' into or out of a LAG port. */
+static void
+lg_apply_lag(const struct ovsrec_interface *ifrow, struct lg_iface *iface)
+{
+    const struct ovsrec_port *own_port, *lag_port;
+    struct ovsrec_interface **members;
+    size_t n = 0, i;
+    int lag;
+
+    lag = iface->lag >= 0 ? iface->lag : random_range(n_lags);
+    own_port = ovsrec_port_get_for_uuid(idl, &iface->port_uuid);
+    lag_port = ovsrec_port_get_for_uuid(idl, &lag_uuids[lag]);
+    if (!own_port || !lag_port) {
+        ovs_fatal(0, "%s: port row deleted", iface->name);
+    }
+
+    members = xmalloc((lag_port->n_interfaces + 1) * sizeof *members);
+    for (i = 0; i < lag_port->n_interfaces; i++) {
+        if (lag_port->interfaces[i] != ifrow) {
+            members[n++] = lag_port->interfaces[i];
+        }
+    }
+
+    if (iface->lag < 0) {
+        members[n++] = CONST_CAST(struct ovsrec_interface *, ifrow);
+        ovsrec_port_set_interfaces(own_port, NULL, 0);
+        ovsrec_interface_update_bond_status_setkey(
+            ifrow, INTERFACE_BOND_STATUS_MAP_STATE, "blocked");
+        iface->lag = lag;
+    } else {
+        ovsrec_port_set_interfaces(
+            own_port, (struct ovsrec_interface **) &ifrow, 1);
+        ovsrec_interface_update_bond_status_delkey(
+            ifrow, INTERFACE_BOND_STATUS_MAP_STATE);
+        iface->lag = -1;
+    }
+    ovsrec_port_set_interfaces(lag_port, members, n);
+    free(members);
+} /* lg_apply_lag */
+
+/* Adds the change of an event of 'stream' on 'iface' to the current
+ * transaction. */
+static void
+lg_apply(struct lg_iface *iface, enum lg_stream stream)
+{
+    const struct ovsrec_interface *ifrow;
+
+    ifrow = ovsrec_interface_get_for_uuid(idl, &iface->uuid);
+    if (!ifrow) {
+        ovs_fatal(0, "%s: interface row deleted", iface->name);
+    }
+
+    switch (stream) {
+    case LG_STREAM_ADMIN:
+        iface->admin_down = !iface->admin_down;
+        ovsrec_interface_update_user_config_setkey(
+            ifrow, INTERFACE_USER_CONFIG_MAP_ADMIN,
+            iface->admin_down ? OVSREC_INTERFACE_USER_CONFIG_ADMIN_DOWN
+                              : OVSREC_INTERFACE_USER_CONFIG_ADMIN_UP);
+        break;
+
+    case LG_STREAM_MODULE:
+        iface->module_absent = !iface->module_absent;
+        lg_set_pm_info(ifrow, iface);
+        break;
+
+    case LG_STREAM_LAG:
+        lg_apply_lag(ifrow, iface);
+        break;
+
+    case LG_STREAM_SPLIT:
+        iface->split = !iface->split;
+        if (iface->split) {
+            ovsrec_interface_update_user_config_setkey(
+                ifrow, INTERFACE_USER_CONFIG_MAP_LANE_SPLIT,
+                INTERFACE_USER_CONFIG_MAP_LANE_SPLIT_SPLIT);
+        } else {
+            ovsrec_interface_update_user_config_delkey(
+                ifrow, INTERFACE_USER_CONFIG_MAP_LANE_SPLIT);
+        }
+        break;
+
+    case LG_N_STREAMS:
+    default:
+        OVS_NOT_REACHED();
+    }
+} /* lg_apply */
+
+/* Starts up to 'n' events of the streams in 'stream_mask', in a single
+ * transaction.  Returns the number of events started. */
+static size_t
+lg_start_events(size_t n, unsigned int stream_mask)
+{
+    enum lg_stream streams[LG_N_STREAMS];
+    struct ovsdb_idl_txn *txn;
+    struct lg_event *event;
+    struct lg_iface *iface;
+    enum lg_stream stream;
+    size_t n_streams = 0, first = n_events;
+    long long int start;
+    size_t i, j, tries;
+
+    for (i = 0; i < LG_N_STREAMS; i++) {
+        if (stream_mask & (1u << i)) {
+            streams[n_streams++] = i;
+        }
+    }
+
+    txn = ovsdb_idl_txn_create(idl);
+    for (i = 0; i < n; i++) {
+        stream = streams[random_range(n_streams)];
+
+        /* Give up on this event if no idle interface is found quickly. */
+        for (tries = 0; tries < 16; tries++) {
+            iface = &ifaces[random_range(n_ifaces)];
+            if (lg_can_start(iface, stream)) {
+                break;
+            }
+        }
+        if (tries == 16) {
+            continue;
+        }
+
+        lg_apply(iface, stream);
+        if (n_events >= allocated_events) {
+            events = x2nrealloc(events, &allocated_events, sizeof *events);
+        }
+        event = &events[n_events++];
+        event->stream = stream;
+        event->ifaces = iface;
+        event->n_ifaces = (stream == LG_STREAM_SPLIT
+                           ? LG_SPLIT_CHILDREN + 1 : 1);
+        for (j = 0; j < event->n_ifaces; j++) {
+            iface[j].busy = true;
+        }
+    }
+
+    start = intfd_perf_start();
+    lg_commit(txn);
+    ovsdb_idl_txn_destroy(txn);
+
+    for (i = first; i < n_events; i++) {
+        events[i].start = start;
+        stats[events[i].stream].events++;
+    }
+    return n_events - first;
+} /* lg_start_events */
+
+static void
+lg_event_remove(size_t i)
+{
+    size_t j;
+
+    for (j = 0; j < events[i].n_ifaces; j++) {
+        events[i].ifaces[j].busy = false;
+    }
+    events[i] = events[--n_events];
+} /* lg_event_remove */
+
+/* Completes the events that converged or timed out. */
+static void
+lg_check_events(long long int timeout_ns)
+{
+    long long int now = intfd_perf_start();
+    struct lg_event *event;
+    size_t i = 0, j;
+
+    while (i < n_events) {
+        event = &events[i];
+        for (j = 0; j < event->n_ifaces; j++) {
+            if (!lg_iface_converged(&event->ifaces[j])) {
+                break;
+            }
+        }
+
+        if (j == event->n_ifaces) {
+            intfd_perf_histogram_record(&stats[event->stream].latency,
+                                        now - event->start);
+        } else if (now - event->start >= timeout_ns) {
+            VLOG_WARN("%s: %s event did not converge",
+                      event->ifaces->name, lg_stream_names[event->stream]);
+            stats[event->stream].timeouts++;
+        } else {
+            i++;
+            continue;
+        }
+        lg_event_remove(i);
+    }
+} /* lg_check_events */
+
+/* Runs the event streams for 'duration' s, then waits for the pending
+ * events to complete. */
+static void
+lg_run(unsigned int rate, unsigned int duration, unsigned int timeout,
+       unsigned int stream_mask)
+{
+    long long int start = time_msec();
+    long long int end = start + duration * 1000LL;
+    unsigned long long int started = 0, due;
+    unsigned int seqno = ovsdb_idl_get_seqno(idl);
+    long long int now;
+
+    for (;;) {
+        now = time_msec();
+        if (now < end) {
+            due = (now - start) * rate / 1000;
+            if (due > started) {
+                /* Events that could not start are not retried. */
+                lg_start_events(MIN(due - started, LG_MAX_EVENTS_PER_TXN),
+                                stream_mask);
+                started += MIN(due - started, LG_MAX_EVENTS_PER_TXN);
+            }
+        } else if (!n_events) {
+            break;
+        }
+
+        ovsdb_idl_run(idl);
+        if (ovsdb_idl_get_seqno(idl) != seqno || n_events) {
+            seqno = ovsdb_idl_get_seqno(idl);
+            lg_check_events(timeout * 1000000LL);
+        }
+
+        ovsdb_idl_wait(idl);
+        if (now < end) {
+            poll_timer_wait_until(start + (started + 1) * 1000 / rate);
+        }
+        if (n_events) {
+            /* Timeouts are checked at least every 100 ms. */
+            poll_timer_wait(100);
+        }
+        poll_block();
+    }
+} /* lg_run */
+
+static void
+lg_print_stats(void)
+{
+    const struct lg_stats *s;
+    int i;
+
+    printf("%-8s %10s %10s %10s %10s %10s %10s\n", "stream", "events",
+           "timeouts", "mean(ms)", "p50(ms)", "p99(ms)", "max(ms)");
+    for (i = 0; i < LG_N_STREAMS; i++) {
+        s = &stats[i];
+        if (!s->events) {
+            continue;
+        }
+        printf("%-8s %10llu %10llu %10.3f %10.3f %10.3f %10.3f\n",
+               lg_stream_names[i], s->events, s->timeouts,
+               s->latency.count
+               ? s->latency.total / (double) s->latency.count / 1e6 : 0.0,
+               intfd_perf_histogram_percentile(&s->latency, 50) / 1e6,
+               intfd_perf_histogram_percentile(&s->latency, 99) / 1e6,
+               s->latency.max / 1e6);
+    }
+} /* lg_print_stats */
+
+static unsigned int
+lg_parse_streams(const char *arg)
+{
+    char *copy = xstrdup(arg);
+    char *token, *save_ptr = NULL;
+    unsigned int mask = 0;
+    int i;
+
+    for (token = strtok_r(copy, ",", &save_ptr); token;
+         token = strtok_r(NULL, ",", &save_ptr)) {
+        for (i = 0; i < LG_N_STREAMS; i++) {
+            if (!strcmp(token, lg_stream_names[i])) {
+                mask |= 1u << i;
+                break;
+            }
+        }
+        if (i == LG_N_STREAMS) {
+            ovs_fatal(0, "--streams: unknown stream %s", token);
+        }
+    }
+    free(copy);
+    return mask;
+} /* lg_parse_streams */
+
+static void
+lg_idl_create(const char *remote)
+{
+    unsigned int seqno;
+
+    idl = ovsdb_idl_create(remote, &ovsrec_idl_class, false, true);
+    ovsdb_idl_add_table(idl, &ovsrec_table_system);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_cur_cfg);
+    ovsdb_idl_add_table(idl, &ovsrec_table_vrf);
+    ovsdb_idl_add_column(idl, &ovsrec_vrf_col_name);
+    ovsdb_idl_add_column(idl, &ovsrec_vrf_col_ports);
+    ovsdb_idl_add_table(idl, &ovsrec_table_port);
+    ovsdb_idl_add_column(idl, &ovsrec_port_col_name);
+    ovsdb_idl_add_column(idl, &ovsrec_port_col_admin);
+    ovsdb_idl_add_column(idl, &ovsrec_port_col_interfaces);
+    ovsdb_idl_add_table(idl, &ovsrec_table_interface);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_name);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_type);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_user_config);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_hw_intf_info);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_pm_info);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_split_parent);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_split_children);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_bond_status);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_error);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_hw_intf_config);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_forwarding_state);
+
+    /* Wait for the initial contents of the database. */
+    seqno = ovsdb_idl_get_seqno(idl);
+    ovsdb_idl_run(idl);
+    while (ovsdb_idl_get_seqno(idl) == seqno) {
+        if (!ovsdb_idl_is_alive(idl)) {
+            ovs_fatal(0, "%s: connection failed (%s)", remote,
+                      ovs_retval_to_string(ovsdb_idl_get_last_error(idl)));
+        }
+        lg_idl_block();
+    }
+} /* lg_idl_create */
+
+static void
+usage(void)
+{
+    printf("%s: load generator for ops-intfd\n"
+           "usage: %s [OPTIONS] [DATABASE]\n"
+           "where DATABASE is a socket on which ovsdb-server is listening\n"
+           "      (default: \"unix:%s/db.sock\").\n"
+           "\nOptions:\n"
+           "  --interfaces=N          synthetic interfaces (default: %d)\n"
+           "  --lags=N                LAG ports (default: %d)\n"
+           "  --streams=S[,S...]      admin, module, lag and/or split\n"
+           "                          (default: all)\n"
+           "  --rate=N                events per second (default: %d)\n"
+           "  --duration=N            seconds of events (default: %d)\n"
+           "  --timeout=N             ms for an event to converge "
+           "(default: %d)\n"
+           "  --seed=N                seed of the interfaces and events\n"
+           "  --keep                  do not delete the rows at exit\n"
+           "  -h, --help              display this help message\n",
+           program_name, program_name, ovs_rundir(), LG_DEFAULT_INTERFACES,
+           LG_DEFAULT_LAGS, LG_DEFAULT_RATE, LG_DEFAULT_DURATION,
+           LG_DEFAULT_TIMEOUT);
+    exit(EXIT_SUCCESS);
+} /* usage */
+
+int
+main(int argc, char *argv[])
+{
+    enum {
+        OPT_INTERFACES = UCHAR_MAX + 1,
+        OPT_LAGS,
+        OPT_STREAMS,
+        OPT_RATE,
+        OPT_DURATION,
+        OPT_TIMEOUT,
+        OPT_SEED,
+        OPT_KEEP,
+        VLOG_OPTION_ENUMS,
+    };
+    static const struct option long_options[] = {
+        {"help",        no_argument, NULL, 'h'},
+        {"interfaces",  required_argument, NULL, OPT_INTERFACES},
+        {"lags",        required_argument, NULL, OPT_LAGS},
+        {"streams",     required_argument, NULL, OPT_STREAMS},
+        {"rate",        required_argument, NULL, OPT_RATE},
+        {"duration",    required_argument, NULL, OPT_DURATION},
+        {"timeout",     required_argument, NULL, OPT_TIMEOUT},
+        {"seed",        required_argument, NULL, OPT_SEED},
+        {"keep",        no_argument, NULL, OPT_KEEP},
+        VLOG_LONG_OPTIONS,
+        {NULL, 0, NULL, 0},
+    };
+    unsigned int n = LG_DEFAULT_INTERFACES;
+    unsigned int rate = LG_DEFAULT_RATE;
+    unsigned int duration = LG_DEFAULT_DURATION;
+    unsigned int timeout = LG_DEFAULT_TIMEOUT;
+    unsigned int stream_mask = (1u << LG_N_STREAMS) - 1;
+    unsigned int seed = 0;
+    bool keep = false;
+    long long int start, setup;
+    char *short_options;
+    char *remote;
+    size_t i;
+
+    set_program_name(argv[0]);
+
+    short_options = long_options_to_short_options(long_options);
+    for (;;) {
+        int c = getopt_long(argc, argv, short_options, long_options, NULL);
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+        case 'h':
+            usage();
+
+        case OPT_INTERFACES:
+            if (!str_to_uint(optarg, 10, &n) || !n) {
+                ovs_fatal(0, "--interfaces argument must be a positive "
+                          "integer");
+            }
+            break;
+
+        case OPT_LAGS:
+            if (!str_to_uint(optarg, 10, &n_lags)) {
+                ovs_fatal(0, "--lags argument must be a non-negative "
+                          "integer");
+            }
+            break;
+
+        case OPT_STREAMS:
+            stream_mask = lg_parse_streams(optarg);
+            break;
+
+        case OPT_RATE:
+            if (!str_to_uint(optarg, 10, &rate) || !rate) {
+                ovs_fatal(0, "--rate argument must be a positive integer");
+            }
+            break;
+
+        case OPT_DURATION:
+            if (!str_to_uint(optarg, 10, &duration)) {
+                ovs_fatal(0, "--duration argument must be a non-negative "
+                          "integer");
+            }
+            break;
+
+        case OPT_TIMEOUT:
+            if (!str_to_uint(optarg, 10, &timeout) || !timeout) {
+                ovs_fatal(0, "--timeout argument must be a positive "
+                          "integer");
+            }
+            break;
+
+        case OPT_SEED:
+            if (!str_to_uint(optarg, 10, &seed)) {
+                ovs_fatal(0, "--seed argument must be a non-negative "
+                          "integer");
+            }
+            break;
+
+        case OPT_KEEP:
+            keep = true;
+            break;
+
+        VLOG_OPTION_HANDLERS
+
+        case '?':
+            exit(EXIT_FAILURE);
+
+        default:
+            abort();
+        }
+    }
+    free(short_options);
+
+    argc -= optind;
+    argv += optind;
+    if (argc > 1) {
+        ovs_fatal(0, "at most one non-option argument accepted; "
+                  "use --help for usage");
+    }
+    remote = (argc ? xstrdup(argv[0])
+              : xasprintf("unix:%s/db.sock", ovs_rundir()));
+    if (!stream_mask) {
+        stream_mask = (1u << LG_N_STREAMS) - 1;
+    }
+    if (!n_lags) {
+        stream_mask &= ~(1u << LG_STREAM_LAG);
+    }
+    if (seed) {
+        random_set_seed(seed);
+    }
+
+    ovsrec_init();
+    lg_idl_create(remote);
+    lg_cleanup();
+    lg_system_configure();
+
+    lg_generate(n);
+    start = intfd_perf_start();
+    lg_insert_all();
+    setup = lg_wait_setup(start);
+    if (setup < 0) {
+        ovs_fatal(0, "%"PRIuSIZE" interfaces did not converge within %d s, "
+                  "is ops-intfd running?", n_ifaces,
+                  LG_SETUP_TIMEOUT / 1000);
+    }
+    printf("%"PRIuSIZE" interfaces converged in %.3f ms\n", n_ifaces,
+           setup / 1e6);
+
+    if (duration && stream_mask) {
+        lg_run(rate, duration, timeout, stream_mask);
+        lg_print_stats();
+    }
+
+    if (!keep) {
+        lg_cleanup();
+    }
+    ovsdb_idl_destroy(idl);
+    for (i = 0; i < n_ifaces; i++) {
+        free(ifaces[i].name);
+        free(ifaces[i].base_error);
+    }
+    free(ifaces);
+    free(lag_uuids);
+    free(events);
+    free(remote);
+
+    return EXIT_SUCCESS;
+} /* main */
@@ -0,0 +1,79 @@
+/*
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+/************************************************************************//**
+ * @ingroup ops-intfd
+ *
+ * @file
+ * Heap allocation counting for the ops-intfd simulation tools.
+ *
+ * The allocator of the C library is interposed, so that allocations made
+ * by the OVS libraries are counted too.  Without glibc nothing is
+ * counted.
+ *
+ ***************************************************************************/
+
+#include <stdlib.h>
+
+#include "sim_alloc.h"
+
+static bool count_allocs;
+static unsigned long long n_allocs;
+
+void
+sim_alloc_count(bool enable)
+{
+    count_allocs = enable;
+} /* sim_alloc_count */
+
+unsigned long long
+sim_alloc_total(void)
+{
+    return n_allocs;
+} /* sim_alloc_total */
+
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *p, size_t size);
+
+void *
+malloc(size_t size)
+{
+    if (count_allocs) {
+        n_allocs++;
+    }
+    return __libc_malloc(size);
+}
+
+void *
+calloc(size_t n, size_t size)
+{
+    if (count_allocs) {
+        n_allocs++;
+    }
+    return __libc_calloc(n, size);
+}
+
+void *
+realloc(void *p, size_t size)
+{
+    if (count_allocs) {
+        n_allocs++;
+    }
+    return __libc_realloc(p, size);
+}
+#endif /* __GLIBC__ */
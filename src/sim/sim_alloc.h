@@ -0,0 +1,37 @@
+/*
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+/************************************************************************//**
+ * @ingroup ops-intfd
+ *
+ * @file
+ * Heap allocation counting for the ops-intfd simulation tools.
+ *
+ ***************************************************************************/
+
+#ifndef __SIM_ALLOC_H__
+#define __SIM_ALLOC_H__
+
+#include <stdbool.h>
+
+/* Starts or stops counting the heap allocations of the calling program.
+ * The counter is not atomic: only count while a single thread runs. */
+extern void sim_alloc_count(bool enable);
+
+/* Returns the number of allocations counted so far. */
+extern unsigned long long sim_alloc_total(void);
+
+#endif /* __SIM_ALLOC_H__ */